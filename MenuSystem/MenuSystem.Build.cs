@@ -8,6 +8,28 @@ public class MenuSystem : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "OnlineSubsystemSteam", "OnlineSubsystem" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "OnlineSubsystem" });
+
+		// Json is only used by the session benchmark commandlet to write its report
+		PrivateDependencyModuleNames.Add("Json");
+
+		// The replication graph replaces the per actor relevancy checks of the lobby's listen server
+		PrivateDependencyModuleNames.Add("ReplicationGraph");
+
+		// GameMapsSettings, to recognize the transition map of the seamless travel to the lobby
+		PrivateDependencyModuleNames.Add("EngineSettings");
+
+		// The lobby preload looks up the assets the lobby map references
+		PrivateDependencyModuleNames.Add("AssetRegistry");
+
+		// Remote characters are throttled by their significance, the SignificanceManager plugin must be enabled in the project
+		PrivateDependencyModuleNames.Add("SignificanceManager");
+
+		// Reservation beacons (OnlineBeaconHost/Client) let joining players check for a free slot before they travel
+		PrivateDependencyModuleNames.Add("OnlineSubsystemUtils");
+
+		// The session code only talks to IMenuSystemSessionBackend, Steam is picked at runtime by the online subsystem config
+		// so builds without the Steam SDK (e.g. Linux CI running the loopback backend) still link.
+		DynamicallyLoadedModuleNames.Add("OnlineSubsystemSteam");
 	}
 }
@@ -2,6 +2,31 @@
 
 #include "MenuSystem.h"
 #include "Modules/ModuleManager.h"
+#include "Engine/NetDriver.h"
+#include "MenuSystemReplicationGraph.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, MenuSystem, "MenuSystem" );
- 
\ No newline at end of file
+void FMenuSystemModule::StartupModule()
+{
+	FDefaultGameModuleImpl::StartupModule();
+
+	//the game net driver replicates through our replication graph. Other net drivers (beacons, demo recording) keep theirs,
+	//returning nullptr lets the net driver fall back to its configured ReplicationDriverClassName
+	UReplicationDriver::CreateReplicationDriverDelegate().BindLambda([](UNetDriver* ForNetDriver, const FURL& URL, UWorld* World) -> UReplicationDriver*
+	{
+		if(ForNetDriver && ForNetDriver->NetDriverName == NAME_GameNetDriver && UMenuSystemReplicationGraph::IsEnabled()){
+			return NewObject<UMenuSystemReplicationGraph>(GetTransientPackage());
+		}
+		return nullptr;
+	});
+}
+
+void FMenuSystemModule::ShutdownModule()
+{
+	UReplicationDriver::CreateReplicationDriverDelegate().Unbind();
+
+	FDefaultGameModuleImpl::ShutdownModule();
+}
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FMenuSystemModule, MenuSystem, "MenuSystem" );
+
+DEFINE_LOG_CATEGORY(LogMenuSystem);
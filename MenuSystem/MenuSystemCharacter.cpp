@@ -6,19 +6,63 @@
 #include "Components/InputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
 #include "GameFramework/SpringArmComponent.h"
-#include "OnlineSubsystem.h"
-#include "OnlineSessionSettings.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "SignificanceManager.h"
+#include "MenuSystemCharacterMovementComponent.h"
+#include "MenuSystemSessionSubsystem.h"
+
+static TAutoConsoleVariable<int32> CVarMenuSystemCharacterSignificance(
+	TEXT("MenuSystem.Significance.Enable"),
+	1,
+	TEXT("Throttle the updates of simulated proxies by their significance (distance to the local player, and whether they were rendered). Read when a character registers."),
+	ECVF_Default
+);
+
+namespace MenuSystemCharacterSignificance
+{
+	// Tag our characters are registered with in the significance manager.
+	static const FName Tag(TEXT("MenuSystemCharacter"));
+
+	// Lowest significance of the high and medium levels, below medium is low, and 0 is insignificant.
+	static constexpr float High = 0.66f;
+	static constexpr float Medium = 0.33f;
+
+	/** Scores a simulated proxy: 1 next to the viewer, 0 at SignificanceMaxDistance and beyond, scaled down if it is not on screen */
+	static float Calculate(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint)
+	{
+		const AMenuSystemCharacter* Character = CastChecked<AMenuSystemCharacter>(ObjectInfo->GetObject());
+		const float MaxDistance = FMath::Max(Character->SignificanceMaxDistance, 1.f);
+		const float Distance = FVector::Dist(Character->GetActorLocation(), Viewpoint.GetLocation());
+
+		float Significance = FMath::Clamp(1.f - Distance / MaxDistance, 0.f, 1.f);
+		if(!Character->WasRecentlyRendered(0.5f)){
+			Significance *= Character->HiddenSignificanceScale;
+		}
+		return Significance;
+	}
+
+	/** Applies a new significance, on the game thread after every scoring pass */
+	static void PostUpdate(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal)
+	{
+		//the level only changes at the thresholds, there is nothing to do as long as we stay in the same one
+		auto GetLevel = [](float Value){ return Value >= High ? 3 : Value >= Medium ? 2 : Value > 0.f ? 1 : 0; };
+		if(GetLevel(OldSignificance) != GetLevel(Significance) || bFinal){
+			CastChecked<AMenuSystemCharacter>(ObjectInfo->GetObject())->ApplySignificance(bFinal ? 1.f : Significance);
+		}
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 // AMenuSystemCharacter
 
-AMenuSystemCharacter::AMenuSystemCharacter():
-	//binding the delegate to the callback function. @ header file we only created a delegate and a callback function, but still need to bind them to tell that the callback funciton is the function of that delegate.
-	CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),		//Here using the CreateUObject function, we are constructing the delegate object (defining the'CreateSessionCompleteDelegate' delegate) as well as passing in the callback function ('OnCreateSessionComplete') to bind to when the delegate is being triggered (itc when the Session is created will trigger the delegate).  We do this after the : of the constructor to use the member initializing list method of initialize a variable (Syntax: VarName(value you want to initialize the variable to)). ITC we want to initialize our variable CreateSessionCompleteDelegate
-	//binding the delegate to the callback function. @ header file we only created a delegate and a callback function, but still need to bind them to tell that the callback funciton is the function of that delegate which is what we're doing here.
-	FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
-	//binding the delegate to the callback function. @ header file we only created a delegate and a callback function, but still need to bind them to tell that the callback funciton is the function of that delegate which is what we're doing here.
-	JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete))
+AMenuSystemCharacter::AMenuSystemCharacter(const FObjectInitializer& ObjectInitializer):
+	//our movement component packs the moves sent to the server, see UMenuSystemCharacterMovementComponent
+	Super(ObjectInitializer.SetDefaultSubobjectClass<UMenuSystemCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -57,22 +101,150 @@ AMenuSystemCharacter::AMenuSystemCharacter():
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 
+	// Lower the animation rate of characters that are small on screen or off screen
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Significance
+
+void AMenuSystemCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UpdateCameraComponents();
+	UpdateSignificanceRegistration();
+}
+
+void AMenuSystemCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterFromSignificanceManager();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMenuSystemCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	UpdateCameraComponents();
+	UpdateSignificanceRegistration();
+}
+
+void AMenuSystemCharacter::UnPossessed()
+{
+	Super::UnPossessed();
 
-	IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
-	if(OnlineSubsystem){
-		OnlineSessionInterface = OnlineSubsystem->GetSessionInterface();			//GetSessionInterface will return the session interface and return all the functions related to the session interface to be stored in "OnlineSessionInterface"
+	UpdateCameraComponents();
+	UpdateSignificanceRegistration();
+}
+
+void AMenuSystemCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	UpdateCameraComponents();
+	UpdateSignificanceRegistration();
+}
+
+void AMenuSystemCharacter::OnRep_Controller()
+{
+	Super::OnRep_Controller();
+
+	UpdateCameraComponents();
+	UpdateSignificanceRegistration();
+}
 
-		if(GEngine){
-			GEngine->AddOnScreenDebugMessage(			//This is similar to the UE_LOG but we can customize the color, the duration, and if we want to replace the previous message if we were to print more than one onscreen message
-				-1,
-				15.f,
-				FColor::Blue,
-				FString::Printf(TEXT("Found Subsystem %s"), *OnlineSubsystem->GetSubsystemName().ToString())		//GetSystemName() returns an FName but we can convert it to an FString using "ToString()"
-			);
+void AMenuSystemCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	//the character of the first local player scores everybody else from its point of view
+	APlayerController* PlayerController = Cast<APlayerController>(Controller);
+	if(PlayerController && PlayerController->IsLocalController() && PlayerController == GetWorld()->GetFirstPlayerController()){
+		if(USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld())){
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+			const FTransform Viewpoint(ViewRotation, ViewLocation);
+			SignificanceManager->Update(TArrayView<const FTransform>(&Viewpoint, 1));
 		}
 	}
 }
 
+void AMenuSystemCharacter::UpdateCameraComponents()
+{
+	const bool bLocallyControlled = IsLocallyControlled();
+	CameraBoom->SetComponentTickEnabled(bLocallyControlled);
+	CameraBoom->SetActive(bLocallyControlled);
+	FollowCamera->SetActive(bLocallyControlled);
+}
+
+void AMenuSystemCharacter::UpdateSignificanceRegistration()
+{
+	//only simulated proxies: our own character is always significant, and the characters the server (listen or dedicated) moves for their clients must tick at full rate
+	const UWorld* World = GetWorld();
+	const bool bShouldRegister = HasActorBegunPlay() && GetLocalRole() == ROLE_SimulatedProxy && World && CVarMenuSystemCharacterSignificance.GetValueOnGameThread() != 0;
+	if(bShouldRegister == bRegisteredForSignificance){
+		return;
+	}
+
+	if(!bShouldRegister){
+		UnregisterFromSignificanceManager();
+		return;
+	}
+
+	if(USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(World)){
+		SignificanceManager->RegisterObject(this, MenuSystemCharacterSignificance::Tag, &MenuSystemCharacterSignificance::Calculate,
+			USignificanceManager::EPostSignificanceType::Sequential, &MenuSystemCharacterSignificance::PostUpdate);
+		bRegisteredForSignificance = true;
+	}
+}
+
+void AMenuSystemCharacter::UnregisterFromSignificanceManager()
+{
+	if(!bRegisteredForSignificance){
+		return;
+	}
+
+	//unregistering calls PostUpdate with bFinal, which restores the full update rates
+	if(USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld())){
+		SignificanceManager->UnregisterObject(this);
+	}
+	bRegisteredForSignificance = false;
+}
+
+void AMenuSystemCharacter::ApplySignificance(float Significance)
+{
+	using namespace MenuSystemCharacterSignificance;
+
+	const AMenuSystemCharacter* Defaults = GetClass()->GetDefaultObject<AMenuSystemCharacter>();
+
+	//the server moves and animates the characters of its clients from their moves, only proxies are throttled.
+	//A character that stopped being a proxy (e.g. possessed since) gets its full rates back
+	if(GetLocalRole() != ROLE_SimulatedProxy){
+		Significance = 1.f;
+	}
+
+	float TickInterval = 0.f;
+	if(Significance < High){
+		TickInterval = Significance >= Medium ? MediumSignificanceTickInterval : Significance > 0.f ? LowSignificanceTickInterval : InsignificantTickInterval;
+	}
+	SetActorTickInterval(TickInterval);
+	GetMesh()->SetComponentTickInterval(TickInterval);
+	GetCharacterMovement()->SetComponentTickInterval(TickInterval);
+
+	//linear smoothing is cheaper than exponential, and not smoothing at all is fine for characters nobody looks at
+	const ENetworkSmoothingMode DefaultSmoothingMode = Defaults->GetCharacterMovement()->NetworkSmoothingMode;
+	GetCharacterMovement()->NetworkSmoothingMode = Significance >= High ? DefaultSmoothingMode
+		: Significance > 0.f ? ENetworkSmoothingMode::Linear
+		: ENetworkSmoothingMode::Disabled;
+
+	//proxies only need their bones on screen
+	GetMesh()->VisibilityBasedAnimTickOption = Significance >= Medium ? Defaults->GetMesh()->VisibilityBasedAnimTickOption : EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -99,184 +271,39 @@ void AMenuSystemCharacter::SetupPlayerInputComponent(class UInputComponent* Play
 	PlayerInputComponent->BindTouch(IE_Released, this, &AMenuSystemCharacter::TouchStopped);
 }
 
-void AMenuSystemCharacter::CreateGameSession() 
-{		
-	// Called when pressing the 1 key
-
-	/* Here we are checking if the online session interface is valid? if not then we simply return out of the function. Then we get the existing session, if one exist with the name "NAME_GameSession", and if that existing session is not a nullptr, we simply destroy the current session with that name, that way we'll be able to create a new session. */
-	if(!OnlineSessionInterface.IsValid()){		//IsValid is the function belong to the TSharedPtr wrapper (which is what the onlinesessioninterface is)
-		return;		//return early
-	}
-
-
-	//Check if a session has already existed?
-	auto ExistingSession = OnlineSessionInterface->GetNamedSession(NAME_GameSession);		//once we start the sessions, we'll be giving them session names. We put Name_GameSession to always be checking to see if the session with such name exist or not.
-	
-	//if the existing session is null, we destroy the session
-	if(ExistingSession != nullptr){
-		OnlineSessionInterface->DestroySession(NAME_GameSession);			//destroy the session with the name given inside the bracket
-	}
-	
-	//adding the delegate we define in the constructor to the session interfaces delegate list using the AddOnCreateSessionCompleteDelegate_Handle() function.
-	OnlineSessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);		//Adding the delegate 'CreateSessionCompleteDelegate' to the OnlineSessionInterface delegate list. Once the successfuly created a session, the callback function that we bound to the delegate (itc its the '&ThisClass::OnCreateSessionComplete' see at the top (at the constructor where we define the delegate to see what callback function we bound to the delegate)) will be executed. So the trigger here is when the the session is created! (other general delegate trigger can be OnHit, OnDamageTaken, etc).
-
-	//Created a new session settings wrapped in a tsharedptr, which we had to use 'MakeSharable()' in order to initialize it with the new FOnlineSessionSettings() object. This is the session settings that we need to passed in to create the sessions (Part of the CreateSession argument below, which we need to complete the argument). And this session settings are also used to configure some of the settings in the sessions which is done down below "SessionSettings->A; SessionSettings->B, SessionSettings->C, etc"
-	TSharedPtr<FOnlineSessionSettings>SessionSettings = MakeShareable(new FOnlineSessionSettings());		//the way to initialize a new tsharepointer is by the use of the MakeSharable(new NameOfTheConstructorWe'reCreating) function
-	
-	//get the first local player in the world and store it in the 'LocalPlayer' variable. We need this to get the preffered unique id which is a function from ULocalPlayer (we need this as a argument of "CreateSession()" below), thus in order to use the function we first need to get the local player stored in ULocalPlayer DT.
-	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();						//get the first local player from its player controller. This returns a ULocalPlayer, and we need this to get the unique net id which required for the CreateSession argument (The function we need is inside the LocalPlayer).
-	
-	//Call the "CreateSession()" function and fill in the arguments
-	OnlineSessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *SessionSettings);		//This part will create the session. Syntax: CreateSession(FUniqueNetId, SessionName, FOnlineSessionSettings). If the argument don't expect a pointer but what we have is a pointer, we can derefence by using the * sign (like what we did to the SessionSettings which is wrapped in a TSharedPtr and thus we need to dereference it (all TSharedPtr need dereference???)). GetPreferredUniqueNetId()>FUniqueNetIdRepl>FUniqueNetIdWrapper>" * Dereference operator returns a reference to the FUniqueNetId" . That is why we dereference the 'LocalPlayer->GetPreferredUniqueNetId()'
-
-
-	//configurations for the session settings:
-
-	//Not connecting to LAN match, we want to connect over the internet
-	SessionSettings->bIsLANMatch = false;
-	//Determines how many player can connect to the game
-	SessionSettings->NumPublicConnections = 4;
-	//if a session is running, other players can join while that session is running
-	SessionSettings->bAllowJoinInProgress = true;
-	//When steam setup game session, it uses something called 'presence'. It doesn't just connect any player from around the world to any other player, it has regions and it searches for sessions currently going on at your region of the world. presence is used such that steam will only connect you to other players in the same region. Now we need to use presence in order for our connectiosn to work, thus setting this 'bAllowJoinViaPresence' to true
-	SessionSettings->bAllowJoinViaPresence = true;
-	//Allows steam to advertise the sessions so other player can find and join that session
-	SessionSettings->bShouldAdvertise = true;
-	//Allows us to use presence inorder to find sessions going on in our region of the world and presence is used such that steam will only connect you to other players in the same region
-	SessionSettings->bUsesPresence = true;
-	//If not use this, after building package, it will return "Create Session Failed". This line is troubleshooting! from qna
-	SessionSettings->bUseLobbiesIfAvailable = true;
-	//Specifying the match type (aka free for all meaning its us against all, or it can be team A vs team B, etc)
-	SessionSettings->Set(FName("MatchType"), FString("FreeForAll"), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);		//Here, we are setting a key value pair for our session in the session settings (hence the 'SessionSettings->...'), once we found the sessions, we can check that. A Set() function allow us to set a key value pair associated with this session that we can check once we found sessions (Syntax = Set(FName Key, ValueType, EOnlineDataAdvertisementType::Type)). 
-}
-
-
-
-//this is the callback function that is going to be called by the delegate!
-void AMenuSystemCharacter::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful) 
+UMenuSystemSessionSubsystem* AMenuSystemCharacter::GetSessionSubsystem() const
 {
-	if(bWasSuccessful){						//if we succeffuly created a session
-
-		if(GEngine){
-			GEngine->AddOnScreenDebugMessage(
-				-1,
-				15.f,
-				FColor::Blue,
-				FString::Printf(TEXT("Success to create session: %s!"), *SessionName.ToString())		//print the sessionname
-			);
-		}
-		UWorld* World = GetWorld();
-		if(World){
-			World->ServerTravel(FString("/Game/ThirdPerson/Maps/Lobby?listen"));		//travel to the level named the one mentioned in the location inside the FString."?" means that there's an option given to us and we can choose what we want from that option. itc we have the option to choose whether we want the server to be a listen or client and we choose listen.
-		}
-	}
-
-	else {									//if we failed to create the session
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			15.f,
-			FColor::Red,
-			FString(TEXT("Failed to create session!"))
-		);
-	}
+	const UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UMenuSystemSessionSubsystem>() : nullptr;
 }
-//this is the callback function that is going to be called by the delegate!
-void AMenuSystemCharacter::JoinGameSession() 
-{
-	//Find Game Sessions
 
-	/* Here we are checking if the online session interface is valid? if not then we simply return out of the function. Then we get the existing session, if one exist with the name "NAME_GameSession", and if that existing session is not a nullptr, we simply destroy the current session with that name, that way we'll be able to create a new session. */
-	if(!OnlineSessionInterface.IsValid()){		//IsValid is the function belong to the TSharedPtr wrapper (which is what the onlinesessioninterface is)
-		return;		//return early
+void AMenuSystemCharacter::CreateGameSession()
+{
+	// Called when pressing the 1 key
+	if(UMenuSystemSessionSubsystem* SessionSubsystem = GetSessionSubsystem()){
+		SessionSubsystem->CreateGameSession();
 	}
-
-	//adding the delegate we define in the constructor to the session interfaces delegate list using the AddOnCreateSessionCompleteDelegate_Handle() function.
-	OnlineSessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);		//Adding the delegate 'FindSessionsCompleteDelegate' to the OnlineSessionInterface delegate list. Once the successfuly created a session, the callback function that we bound to the delegate (itc its the '&ThisClass::OnFindSessionComplete' see at the top (at the constructor where we define the delegate to see what callback function we bound to the delegate)) will be executed. So the trigger here is when "FindSessions()" has completed! (other general delegate trigger can be OnHit, OnDamageTaken, etc).
-	//We made SessionSearch as a member variable (aka putting it outside this "OnFindSessionComplete()" function, so we need to make it global for this class in the header file private section) instead of local variable bcs we need to access the function (search result) from this 'SessionSearch' variable, that is why we make it SharePtr and not ShareRef in the first place, is that bcs we want to make this as a variable in order to use the function it stores from its datatype (which is FOnlineSessionSearchResult). Similar to SessionSettings earlier above, we had to use 'MakeSharable()' in order to initialize it with the new FOnlineSessionSearch() object. This is the session search that we need to passed in to find the sessions (Part of the FindSessions() argument below, which we need to complete the argument). And this session settings are also used to configure some of the settings in the sessions which is done down below "SessionSearch->A; SessionSearch->B, SessionSearch->C, etc"
-	SessionSearch = MakeShareable(new FOnlineSessionSearch());
-	//Remember that we are using the DevAppID of 480? (written in the defaultengine.ini). This is shared among lots of people who also are using this DevAppID cos they dont have their own. We set this number to a high value such that there will be a good chance that we find lots of sessions when we search for them. Thus, this will be the sessions used by other developers using the Dev App ID of 480.
-	SessionSearch->MaxSearchResults = 10000;
-	//we are not connecting using LAN network
-	SessionSearch->bIsLanQuery = false;
-	//Since we are using presence (aka to know which region are we in? and will only connect you to other players in the same region), we need to set the query settings to make sure that any sessions we find are using presence. if you hover over querysettings, it says that it is used to find matching servers. Syntax: QuerySettings(A Macro (key), set the query search presence to true/false?, Comparison Operator(we passed in an Enum, hence the '::') )
-	SessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
-	
-	//get the first local player in the world and store it in the 'LocalPlayer' variable. We need this to get the preffered unique id which is a function from ULocalPlayer (we need this as a argument of "FindSession()" below), thus in order to use the function we first need to get the local player stored in ULocalPlayer DT.
-	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();						//get the first local player from its player controller. This returns a ULocalPlayer, and we need this to get the unique net id which required for the CreateSession argument (The function we need is inside the LocalPlayer).
-	//calling find sessions
-	OnlineSessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(),SessionSearch.ToSharedRef());		//different from "CreateSession()", "FindSession()" will need a SharedRef and not SharedPtr. Well, we can actually make it as SharedPtr rightfrom the start but the reason why we make it as a sharedptr is that we later plan on makin this variables on this class so that we can access information on them later.
 }
 
-void AMenuSystemCharacter::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result) 
+void AMenuSystemCharacter::JoinGameSession()
 {
-	if(!OnlineSessionInterface.IsValid()){		//if this is not (negation symbol !) valid, then return early
-		return;
-	}
-
-	FString Address;
-	if(OnlineSessionInterface->GetResolvedConnectString(NAME_GameSession,  Address)){		// if you hover over "GetResolvedConnectString()" it says that it returns the platform specific connection infomration (like the IP address) for joining the match and it is stored in an FString that we specified in its second parameter (itc the second parameter is an FString called "Address", thus we're storing the platform specific connection information in a variable called "Address"). This function must be called from the delegate join completion (which is what were doing! we are calling this funciton on "void OnJoinSessionComplete()", which will be called once joining the sessions have been completed. Syntax = GetResolvedConnectString(FName for the session name, FString for the connect info which is a reference which mean that the parameter can be overwritten! itc we want to fill in the FString Address with the adress we need). GetResolvedConnectString returns a boolean
-		//we only reach here if GetResolvedConnectString returns true (since "GetResolvedConnectString()" is a boolean )
-		if(GEngine){
-			GEngine->AddOnScreenDebugMessage(
-				-1,
-				15.f,
-				FColor::Yellow,
-				FString::Printf(TEXT("Connect String on Address: %s"), *Address)
-			);
-		}
-	 	APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
-		if(PlayerController){
-			PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);					//ClientTravel() function allows us to travel to the IP adress specified in the argument, itc its "Address" which we get from the "GetResolvedConnectString()"" function above. This function returns the platform specific connection information (like the IP address) for joining the match and it is stored in an FString that we specified in its second parameter (itc the second parameter is an FString called "Address", thus we're storing the platform specific connection information in a variable called "Address"). The TravelType::Travel_Absolute will be discussed in future lecture, for now we just gonna use travel absolute.
-		}
+	if(UMenuSystemSessionSubsystem* SessionSubsystem = GetSessionSubsystem()){
+		SessionSubsystem->JoinGameSession();
 	}
-	
 }
-void AMenuSystemCharacter::OnFindSessionsComplete(bool bWasSuccessful) 
 
+void AMenuSystemCharacter::ApplyBotInput(float Forward, float Right, float TurnRate, bool bJump)
 {
+	MoveForward(Forward);
+	MoveRight(Right);
+	TurnAtRate(TurnRate);
 
-	if(!OnlineSessionInterface.IsValid()){		//if this is not valid, then return early
-		return;		//return early
-
+	if(bJump){
+		Jump();
 	}
-	//we have set SessionSearch as a member variable in the header file, thus able to use it directly wo assigning its DT.	
-	//Since SearchResults (Function of sessionsearch pointer) is a TArray, means that we can loop throgh it. We then Loop through the Tarray of FOnlineSessionSearchResult and do something for each result:
-	for(auto Result:SessionSearch->SearchResults)
-	{
-		//Getting the session ID string from the SearchResults function
-		FString Id = Result.GetSessionIdStr();
-		//Getting the owning username
-		FString User = Result.Session.OwningUserName;
-		//since we are now getting the data from looping the searchresults, we can also see if it has a key matching value pair that we are looking for (itc its "MatchType")
-		FString MatchType;
-		Result.Session.SessionSettings.Get(FName("MatchType"), MatchType);	//This Get function will fill in that match type FString if this particular session has the key "MatchType", and if it does, it will access the value and set our local match type variable to that value. So if we have done that, we can then see if that match type value equals "FreeForAll", which is the match type we specify above in the "void CreateGameSession()". Get() function allow us to specify the key for the key value pair to check if it has that key (itc its checking if it has the key named "MatchType"). The value (second argument for the Get() function) is a reference, and a reference inside a function means that we can overwrite that parameter with something! putting void (&A) means that we can overwrite the A variable, whereas not putting & can't... Check utube about 'reference' if still in doubt. ITC, we want to overwrite the "FString MatchType" with whatever the match type we have assigned to the sessions, itc its a freeforall match type ( can be others too! e.g. Team A vs Team B Game, etc)
-
-		//since we are looping the SearchResult in a for loop, we can now print a debug message once it gets its username ('User) and id ('Id).
-		if(GEngine){
-			GEngine->AddOnScreenDebugMessage(
-				-1,
-				15.f,
-				FColor::Cyan,
-				FString::Printf(TEXT("Id: %s, User: %s"), *Id, *User)
-			);
-		}
-		//so if the session we found has the key "MatchType" and its value is "FreeForAll", then we know we are joining a free for all match then it will execute the code below this section (itc we're adding a debug message if the session has the key MatchType and the value is freeforall).
-		if(MatchType == FString("FreeForAll")){
-			if(GEngine){
-				GEngine->AddOnScreenDebugMessage(
-					-1,
-					15.f,
-					FColor::Cyan,
-					FString::Printf(TEXT("Joining Match Type: %s"), *MatchType)
-				);
-			}
-			OnlineSessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate); //Adding the delegate 'JoinSessionCompleteDelegate' to the OnlineSessionInterface delegate list. Once the successfuly created a session, the callback function that we bound to the delegate (itc its the '&ThisClass::OnJoinSessionComplete' see at the top (at the constructor where we define the delegate to see what callback function we bound to the delegate)) will be executed. So the trigger here is when the the session is created! (other general delegate trigger can be OnHit, OnDamageTaken, etc). This callback will be called once the triggered is launced (itc, its after joining session has been completed)
-			//get the first local player in the world and store it in the 'LocalPlayer' variable. We need this to get the preffered unique id which is a function from ULocalPlayer (we need this as a argument of "CreateSession()" below), thus in order to use the function we first need to get the local player stored in ULocalPlayer DT.
-			const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();						//get the first local player from its player controller. This returns a ULocalPlayer, and we need this to get the unique net id which required for the CreateSession argument (The function we need is inside the LocalPlayer).
-			OnlineSessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, Result);
-		}
+	else{
+		StopJumping();
 	}
-
 }
 
 void AMenuSystemCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Location)
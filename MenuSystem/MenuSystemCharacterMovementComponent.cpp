@@ -0,0 +1,405 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemCharacterMovementComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarMenuSystemPackedMoves(
+	TEXT("MenuSystem.Movement.PackedMoves"),
+	-1,
+	TEXT("Move format sent by the local characters, to compare the upstream bandwidth of both: -1 uses bUsePackedMoves, 0 the stock format, 1 the packed format."),
+	ECVF_Default
+);
+
+namespace MenuSystemMovement
+{
+	// Deltas are only taken against a base less than half the sequence range old, so the server can't have overwritten it yet.
+	static const uint8 MaxDeltaSequenceDistance = 127;
+
+	// Acceleration is sent as a fraction of the max acceleration, in steps of 1/AccelerationSteps.
+	static const int32 AccelerationSteps = 127;
+
+	static int32 QuantizeAccelerationAxis(double Value, float MaxAccel)
+	{
+		return FMath::RoundToInt(Value / MaxAccel * AccelerationSteps);
+	}
+
+	static FMenuSystemQuantizedMove QuantizeMove(float TimeStamp, const FVector& Location, const FRotator& ControlRotation)
+	{
+		FMenuSystemQuantizedMove Move;
+		Move.TimeStamp = TimeStamp;
+		Move.Location = FIntVector(FMath::RoundToInt(Location.X * 100.), FMath::RoundToInt(Location.Y * 100.), FMath::RoundToInt(Location.Z * 100.));
+		Move.Yaw = FRotator::CompressAxisToShort(ControlRotation.Yaw);
+		Move.Pitch = FRotator::CompressAxisToShort(ControlRotation.Pitch);
+		Move.Roll = FRotator::CompressAxisToShort(ControlRotation.Roll);
+		Move.bValid = true;
+		return Move;
+	}
+
+	uint32 EncodeZigZag(int32 Value)
+	{
+		return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+	}
+
+	int32 DecodeZigZag(uint32 Value)
+	{
+		return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+	}
+
+	void SerializePackedInts(FArchive& Ar, int32* Values, int32 NumValues)
+	{
+		uint32 NumBits = 0;
+		if(Ar.IsSaving()){
+			for(int32 Index = 0; Index < NumValues; Index++){
+				NumBits = FMath::Max(NumBits, 32 - FMath::CountLeadingZeros(EncodeZigZag(Values[Index])));
+			}
+		}
+
+		Ar.SerializeBits(&NumBits, 6);
+		if(NumBits > 32){
+			Ar.SetError();
+			return;
+		}
+
+		for(int32 Index = 0; Index < NumValues; Index++){
+			uint32 ZigZag = Ar.IsSaving() ? EncodeZigZag(Values[Index]) : 0;
+			if(NumBits > 0){
+				Ar.SerializeBits(&ZigZag, NumBits);
+			}
+			if(Ar.IsLoading()){
+				Values[Index] = DecodeZigZag(ZigZag);
+			}
+		}
+	}
+
+	uint16 GetTimeStampCheckBits(float TimeStamp)
+	{
+		//the low mantissa bits: moves a few frames apart already differ in them
+		uint32 Bits = 0;
+		FMemory::Memcpy(&Bits, &TimeStamp, sizeof(Bits));
+		return (uint16)Bits;
+	}
+
+	/** A single bit telling whether the value differs from its default, and the value itself only if it does */
+	template<typename T>
+	static void SerializeOptional(FArchive& Ar, T& Value, const T& DefaultValue)
+	{
+		uint8 bHasValue = Ar.IsSaving() && Value != DefaultValue;
+		Ar.SerializeBits(&bHasValue, 1);
+		if(bHasValue){
+			Ar << Value;
+		}
+		else if(Ar.IsLoading()){
+			Value = DefaultValue;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemSavedMove
+
+void FMenuSystemSavedMove::Clear()
+{
+	Super::Clear();
+
+	Sequence = 0;
+}
+
+void FMenuSystemSavedMove::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	//our movement component only ever creates our prediction data
+	Sequence = static_cast<FMenuSystemNetworkPredictionData_Client&>(ClientData).NextMoveSequence++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemNetworkPredictionData_Client
+
+FMenuSystemNetworkPredictionData_Client::FMenuSystemNetworkPredictionData_Client(const UCharacterMovementComponent& ClientMovement):
+	Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FMenuSystemNetworkPredictionData_Client::AllocateNewMove()
+{
+	return FSavedMovePtr(new FMenuSystemSavedMove());
+}
+
+void FMenuSystemNetworkPredictionData_Client::RecordSentMove(uint8 Sequence, const FMenuSystemQuantizedMove& Move)
+{
+	//already recorded, the values the server may have stored must not change under it
+	if(SentMoves[Sequence].bValid && SentMoves[Sequence].TimeStamp == Move.TimeStamp){
+		return;
+	}
+
+	//the sequence wrapped around onto the acknowledged move, the server no longer has the base we know
+	if(AckedSequence == Sequence && SentMoves[Sequence].TimeStamp != Move.TimeStamp){
+		AckedSequence = INDEX_NONE;
+	}
+	SentMoves[Sequence] = Move;
+}
+
+void FMenuSystemNetworkPredictionData_Client::AckMove(float TimeStamp)
+{
+	for(int32 Sequence = 0; Sequence < UE_ARRAY_COUNT(SentMoves); Sequence++){
+		if(SentMoves[Sequence].bValid && SentMoves[Sequence].TimeStamp == TimeStamp){
+			AckedSequence = Sequence;
+			return;
+		}
+	}
+}
+
+const FMenuSystemQuantizedMove* FMenuSystemNetworkPredictionData_Client::GetDeltaBase(uint8 Sequence, uint8& OutBaseSequence) const
+{
+	if(AckedSequence == INDEX_NONE){
+		return nullptr;
+	}
+
+	OutBaseSequence = (uint8)AckedSequence;
+	if((uint8)(Sequence - OutBaseSequence) > MenuSystemMovement::MaxDeltaSequenceDistance){
+		return nullptr;
+	}
+	return &SentMoves[OutBaseSequence];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemNetworkPredictionData_Server
+
+FMenuSystemNetworkPredictionData_Server::FMenuSystemNetworkPredictionData_Server(const UCharacterMovementComponent& ServerMovement):
+	Super(ServerMovement)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemCharacterNetworkMoveData
+
+void FMenuSystemCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	Sequence = static_cast<const FMenuSystemSavedMove&>(ClientMove).Sequence;
+}
+
+bool FMenuSystemCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	if(!bPackedMove){
+		return Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+	}
+
+	UMenuSystemCharacterMovementComponent& MovementComponent = static_cast<UMenuSystemCharacterMovementComponent&>(CharacterMovement);
+	NetworkMoveType = MoveType;
+	const bool bIsSaving = Ar.IsSaving();
+	bool bLocalSuccess = true;
+
+	//the time stamp stays exact, the client finds the move the server acknowledges by comparing it
+	Ar << TimeStamp;
+	Ar << Sequence;
+
+	//walking and falling accelerations are the (rounded) input direction times the max acceleration, two bytes hold them
+	int8 AccelerationX = 0;
+	int8 AccelerationY = 0;
+	uint8 bPackedAcceleration = bIsSaving && MovementComponent.PackAcceleration(Acceleration, AccelerationX, AccelerationY);
+	Ar.SerializeBits(&bPackedAcceleration, 1);
+	if(bPackedAcceleration){
+		Ar << AccelerationX;
+		Ar << AccelerationY;
+		if(!bIsSaving){
+			Acceleration = MovementComponent.UnpackAcceleration(AccelerationX, AccelerationY);
+		}
+	}
+	else{
+		Acceleration.NetSerialize(Ar, PackageMap, bLocalSuccess);
+	}
+
+	//location and control rotation are sent as deltas against the last move the server acknowledged, when we have one.
+	//Only new moves become bases: the location of a new move may be relative to its movement base, the one of a resent move is absolute,
+	//so the values of a sequence depend on how it was sent and both ends only keep the ones of its new move
+	const bool bRecordAsBase = MoveType == ENetworkMoveType::NewMove;
+	FMenuSystemQuantizedMove Move;
+	FMenuSystemQuantizedMove Base;
+	uint8 BaseSequence = 0;
+	uint8 bHasBase = 0;
+	if(bIsSaving){
+		Move = MenuSystemMovement::QuantizeMove(TimeStamp, Location, ControlRotation);
+
+		FMenuSystemNetworkPredictionData_Client* ClientData = static_cast<FMenuSystemNetworkPredictionData_Client*>(MovementComponent.GetPredictionData_Client_Character());
+		if(const FMenuSystemQuantizedMove* DeltaBase = ClientData->GetDeltaBase(Sequence, BaseSequence)){
+			Base = *DeltaBase;
+			bHasBase = 1;
+		}
+		if(bRecordAsBase){
+			//exactly what the server decodes, the quantized values are sent losslessly
+			ClientData->RecordSentMove(Sequence, Move);
+		}
+	}
+
+	FMenuSystemNetworkPredictionData_Server* ServerData = bIsSaving ? nullptr : static_cast<FMenuSystemNetworkPredictionData_Server*>(MovementComponent.GetPredictionData_Server_Character());
+
+	Ar.SerializeBits(&bHasBase, 1);
+	if(bHasBase){
+		//the sequence alone can't tell the base apart from an older or newer move in its slot (lost or reordered packets,
+		//or the sequence wrapped around since), the low bits of its time stamp can
+		uint16 BaseTimeStampBits = bIsSaving ? MenuSystemMovement::GetTimeStampCheckBits(Base.TimeStamp) : 0;
+		Ar << BaseSequence;
+		Ar << BaseTimeStampBits;
+		if(!bIsSaving){
+			Base = ServerData->GetReceivedMove(BaseSequence);
+			if(!Base.bValid || MenuSystemMovement::GetTimeStampCheckBits(Base.TimeStamp) != BaseTimeStampBits){
+				//the client built on a move we never received, or no longer have, nothing of this packet can be trusted
+				Ar.SetError();
+				return false;
+			}
+		}
+	}
+
+	int32 LocationDelta[3] = { Move.Location.X - Base.Location.X, Move.Location.Y - Base.Location.Y, Move.Location.Z - Base.Location.Z };
+	MenuSystemMovement::SerializePackedInts(Ar, LocationDelta, UE_ARRAY_COUNT(LocationDelta));
+
+	//16 bit axes wrap around, so the shortest way between two angles is an int16
+	int32 RotationDelta[2] = { (int16)(Move.Yaw - Base.Yaw), (int16)(Move.Pitch - Base.Pitch) };
+	MenuSystemMovement::SerializePackedInts(Ar, RotationDelta, UE_ARRAY_COUNT(RotationDelta));
+
+	//player controllers don't roll, it only costs a bit
+	MenuSystemMovement::SerializeOptional<uint16>(Ar, Move.Roll, 0);
+
+	if(!bIsSaving){
+		Move.TimeStamp = TimeStamp;
+		Move.Location = FIntVector(Base.Location.X + LocationDelta[0], Base.Location.Y + LocationDelta[1], Base.Location.Z + LocationDelta[2]);
+		Move.Yaw = (uint16)(Base.Yaw + RotationDelta[0]);
+		Move.Pitch = (uint16)(Base.Pitch + RotationDelta[1]);
+		Move.bValid = !Ar.IsError();
+		if(bRecordAsBase){
+			ServerData->RecordReceivedMove(Sequence, Move);
+		}
+
+		Location = FVector(Move.Location.X, Move.Location.Y, Move.Location.Z) / 100.;
+		ControlRotation = FRotator(FRotator::DecompressAxisFromShort(Move.Pitch), FRotator::DecompressAxisFromShort(Move.Yaw), FRotator::DecompressAxisFromShort(Move.Roll));
+	}
+
+	MenuSystemMovement::SerializeOptional<uint8>(Ar, CompressedMoveFlags, 0);
+
+	if(MoveType == ENetworkMoveType::NewMove){
+		//like the stock format, movement base and mode are only used to check the final move for errors
+		MenuSystemMovement::SerializeOptional<UPrimitiveComponent*>(Ar, MovementBase, nullptr);
+		MenuSystemMovement::SerializeOptional<FName>(Ar, MovementBaseBoneName, NAME_None);
+		MenuSystemMovement::SerializeOptional<uint8>(Ar, MovementMode, MOVE_Walking);
+	}
+
+	return bLocalSuccess && !Ar.IsError();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemCharacterNetworkMoveDataContainer
+
+FMenuSystemCharacterNetworkMoveDataContainer::FMenuSystemCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &PackedMoveData[0];
+	PendingMoveData = &PackedMoveData[1];
+	OldMoveData = &PackedMoveData[2];
+}
+
+void FMenuSystemCharacterNetworkMoveDataContainer::ClientFillNetworkMoveData(const FSavedMove_Character* ClientNewMove, const FSavedMove_Character* ClientPendingMove, const FSavedMove_Character* ClientOldMove)
+{
+	const ACharacter* CharacterOwner = ClientNewMove ? ClientNewMove->CharacterOwner.Get() : nullptr;
+	const UMenuSystemCharacterMovementComponent* MovementComponent = CharacterOwner ? Cast<UMenuSystemCharacterMovementComponent>(CharacterOwner->GetCharacterMovement()) : nullptr;
+	bPackedMoves = MovementComponent && MovementComponent->ShouldSendPackedMoves();
+
+	Super::ClientFillNetworkMoveData(ClientNewMove, ClientPendingMove, ClientOldMove);
+}
+
+bool FMenuSystemCharacterNetworkMoveDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	uint8 bPacked = bPackedMoves;
+	Ar.SerializeBits(&bPacked, 1);
+	bPackedMoves = bPacked != 0;
+
+	for(FMenuSystemCharacterNetworkMoveData& MoveData : PackedMoveData){
+		MoveData.bPackedMove = bPackedMoves;
+	}
+	return Super::Serialize(CharacterMovement, Ar, PackageMap);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UMenuSystemCharacterMovementComponent
+
+UMenuSystemCharacterMovementComponent::UMenuSystemCharacterMovementComponent()
+{
+	SetNetworkMoveDataContainer(PackedMoveDataContainer);
+}
+
+FNetworkPredictionData_Client* UMenuSystemCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if(ClientPredictionData == nullptr){
+		UMenuSystemCharacterMovementComponent* MutableThis = const_cast<UMenuSystemCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FMenuSystemNetworkPredictionData_Client(*this);
+	}
+	return ClientPredictionData;
+}
+
+FNetworkPredictionData_Server* UMenuSystemCharacterMovementComponent::GetPredictionData_Server() const
+{
+	//created on the first move received, so simulated proxies and the characters of the host don't carry the received moves
+	if(ServerPredictionData == nullptr){
+		UMenuSystemCharacterMovementComponent* MutableThis = const_cast<UMenuSystemCharacterMovementComponent*>(this);
+		MutableThis->ServerPredictionData = new FMenuSystemNetworkPredictionData_Server(*this);
+	}
+	return ServerPredictionData;
+}
+
+bool UMenuSystemCharacterMovementComponent::ShouldSendPackedMoves() const
+{
+	const int32 PackedMovesOverride = CVarMenuSystemPackedMoves.GetValueOnGameThread();
+	return PackedMovesOverride >= 0 ? PackedMovesOverride != 0 : bUsePackedMoves;
+}
+
+FVector UMenuSystemCharacterMovementComponent::RoundAcceleration(FVector InAccel) const
+{
+	//the saved move keeps the rounded acceleration and the client moves with it, so it must be exactly what the server unpacks
+	if(CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_AutonomousProxy && ShouldSendPackedMoves() && FMath::IsNearlyZero(InAccel.Z)){
+		const float MaxAccel = GetMaxAcceleration();
+		if(MaxAccel > 0.f){
+			const int32 X = FMath::Clamp(MenuSystemMovement::QuantizeAccelerationAxis(InAccel.X, MaxAccel), -MenuSystemMovement::AccelerationSteps, MenuSystemMovement::AccelerationSteps);
+			const int32 Y = FMath::Clamp(MenuSystemMovement::QuantizeAccelerationAxis(InAccel.Y, MaxAccel), -MenuSystemMovement::AccelerationSteps, MenuSystemMovement::AccelerationSteps);
+			return UnpackAcceleration((int8)X, (int8)Y);
+		}
+	}
+	return Super::RoundAcceleration(InAccel);
+}
+
+bool UMenuSystemCharacterMovementComponent::PackAcceleration(const FVector& InAccel, int8& OutX, int8& OutY) const
+{
+	const float MaxAccel = GetMaxAcceleration();
+	if(MaxAccel <= 0.f || InAccel.Z != 0.f){
+		return false;
+	}
+
+	const int32 X = MenuSystemMovement::QuantizeAccelerationAxis(InAccel.X, MaxAccel);
+	const int32 Y = MenuSystemMovement::QuantizeAccelerationAxis(InAccel.Y, MaxAccel);
+	if(FMath::Abs(X) > MenuSystemMovement::AccelerationSteps || FMath::Abs(Y) > MenuSystemMovement::AccelerationSteps){
+		return false;
+	}
+
+	OutX = (int8)X;
+	OutY = (int8)Y;
+
+	//an acceleration we did not round (e.g. sent before the mode was switched on) goes in full, or the server would move differently
+	return UnpackAcceleration(OutX, OutY).Equals(InAccel, KINDA_SMALL_NUMBER);
+}
+
+FVector UMenuSystemCharacterMovementComponent::UnpackAcceleration(int8 X, int8 Y) const
+{
+	const float MaxAccel = GetMaxAcceleration();
+	return FVector(X * MaxAccel / MenuSystemMovement::AccelerationSteps, Y * MaxAccel / MenuSystemMovement::AccelerationSteps, 0.f);
+}
+
+void UMenuSystemCharacterMovementComponent::ClientAckGoodMove_Implementation(float TimeStamp)
+{
+	//before Super, which drops the acknowledged move from the saved moves
+	if(HasPredictionData_Client()){
+		static_cast<FMenuSystemNetworkPredictionData_Client*>(GetPredictionData_Client_Character())->AckMove(TimeStamp);
+	}
+
+	Super::ClientAckGoodMove_Implementation(TimeStamp);
+}
@@ -0,0 +1,161 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "MenuSystemCharacterMovementComponent.generated.h"
+
+/**
+ * Move values as they are sent in the packed format: location in 1/100 cm (the precision of FVector_NetQuantize100)
+ * and the control rotation in 16 bits per axis. Both ends keep them for the recent moves, so a move can be sent as a delta.
+ * Only the values a move was sent with as the new move of a packet are kept: resent as an old or pending move its location
+ * is the absolute saved location, not the (possibly base relative) one of the new move, and the two ends must agree on the base.
+ */
+struct FMenuSystemQuantizedMove
+{
+	float TimeStamp = 0.f;
+	FIntVector Location = FIntVector::ZeroValue;
+	uint16 Yaw = 0;
+	uint16 Pitch = 0;
+	uint16 Roll = 0;
+	bool bValid = false;
+};
+
+/** Building blocks of the packed format */
+namespace MenuSystemMovement
+{
+	/** Maps signed values to unsigned ones so small negative values need as few bits as small positive ones: 0, -1, 1, -2 become 0, 1, 2, 3 */
+	uint32 EncodeZigZag(int32 Value);
+	int32 DecodeZigZag(uint32 Value);
+
+	/**
+	 * Serializes signed values with as few bits as the largest of them needs: a 6 bit length, then every value zigzag encoded
+	 * in that many bits. A move without change costs 6 bits.
+	 */
+	void SerializePackedInts(FArchive& Ar, int32* Values, int32 NumValues);
+
+	/** The low bits of a time stamp, sent along a delta so the server can check it decodes against the base the client used */
+	uint16 GetTimeStampCheckBits(float TimeStamp);
+}
+
+/** Saved move carrying the sequence number the packed format identifies it by. */
+class FMenuSystemSavedMove : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+
+	uint8 Sequence = 0;
+};
+
+/** Client prediction data: hands out move sequence numbers and remembers what was sent for them and which one the server acknowledged. */
+class FMenuSystemNetworkPredictionData_Client : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	explicit FMenuSystemNetworkPredictionData_Client(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+
+	/** Records the values a move was first sent with as a new move, they may become the base of later moves once the server acknowledges it */
+	void RecordSentMove(uint8 Sequence, const FMenuSystemQuantizedMove& Move);
+
+	/** Makes the sent move with this time stamp the base of the next deltas */
+	void AckMove(float TimeStamp);
+
+	/** Returns the acknowledged move a move with this sequence can be sent as a delta of, or nullptr to send it whole */
+	const FMenuSystemQuantizedMove* GetDeltaBase(uint8 Sequence, uint8& OutBaseSequence) const;
+
+	uint8 NextMoveSequence = 0;
+
+private:
+	FMenuSystemQuantizedMove SentMoves[256];
+	int32 AckedSequence = INDEX_NONE;
+};
+
+/** Server prediction data: the moves received in the packed format, by sequence number. Only allocated for the characters that send us moves. */
+class FMenuSystemNetworkPredictionData_Server : public FNetworkPredictionData_Server_Character
+{
+public:
+	typedef FNetworkPredictionData_Server_Character Super;
+
+	explicit FMenuSystemNetworkPredictionData_Server(const UCharacterMovementComponent& ServerMovement);
+
+	/** Remembers the values of a new move received in the packed format, later moves of the client are deltas against them */
+	void RecordReceivedMove(uint8 Sequence, const FMenuSystemQuantizedMove& Move) { ReceivedMoves[Sequence] = Move; }
+	const FMenuSystemQuantizedMove& GetReceivedMove(uint8 Sequence) const { return ReceivedMoves[Sequence]; }
+
+private:
+	FMenuSystemQuantizedMove ReceivedMoves[256];
+};
+
+/**
+ * Network move data with a packed format next to the stock one. Instead of a full precision acceleration and location:
+ * - the acceleration of walking and falling moves (no Z) is sent as two signed bytes, a fraction of the max acceleration,
+ * - the location and the control rotation (yaw and pitch, 16 bits each) are sent as deltas against the last move the server acknowledged.
+ */
+struct FMenuSystemCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+
+	uint8 Sequence = 0;
+
+	// Set by the container for every packet, false means the stock format.
+	bool bPackedMove = false;
+};
+
+/** Holds our move data, and a leading bit per packet telling the server which format the client chose. */
+struct FMenuSystemCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	typedef FCharacterNetworkMoveDataContainer Super;
+
+	FMenuSystemCharacterNetworkMoveDataContainer();
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character* ClientNewMove, const FSavedMove_Character* ClientPendingMove, const FSavedMove_Character* ClientOldMove) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+
+private:
+	FMenuSystemCharacterNetworkMoveData PackedMoveData[3];
+	bool bPackedMoves = false;
+};
+
+/**
+ * Character movement sending its moves to the server in the packed format of FMenuSystemCharacterNetworkMoveData.
+ * The client picks the format per packet (bUsePackedMoves, or MenuSystem.Movement.PackedMoves to compare both), the server reads either.
+ */
+UCLASS(config=Game)
+class UMenuSystemCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMenuSystemCharacterMovementComponent();
+
+	// UCharacterMovementComponent interface
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual FNetworkPredictionData_Server* GetPredictionData_Server() const override;
+	virtual FVector RoundAcceleration(FVector InAccel) const override;
+	virtual void ClientAckGoodMove_Implementation(float TimeStamp) override;
+	// End of UCharacterMovementComponent interface
+
+	/** Returns true if the moves of this (locally controlled) character are sent in the packed format */
+	bool ShouldSendPackedMoves() const;
+
+	/** Quantizes an acceleration to two signed bytes. Returns false if it can't be represented exactly (it has a Z, or was not rounded by us) */
+	bool PackAcceleration(const FVector& InAccel, int8& OutX, int8& OutY) const;
+	FVector UnpackAcceleration(int8 X, int8 Y) const;
+
+	/** Send moves in the packed format. Only the client's setting matters, the server reads both formats */
+	UPROPERTY(Category="Character Movement (Networking)", EditAnywhere, BlueprintReadWrite, Config)
+	bool bUsePackedMoves = true;
+
+private:
+	FMenuSystemCharacterNetworkMoveDataContainer PackedMoveDataContainer;
+};
@@ -2,14 +2,135 @@
 
 #include "MenuSystemGameMode.h"
 #include "MenuSystemCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "OnlineBeaconHost.h"
+#include "MenuSystem.h"
+#include "MenuSystemReservationBeacon.h"
+#include "MenuSystemSessionSubsystem.h"
 
 AMenuSystemGameMode::AMenuSystemGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// set default pawn class to our Blueprinted character. It is only referenced here and streamed in by InitGame, loading it
+	// with the game mode would pull the character and all its meshes, animations and materials into startup
+	DefaultPawnSoftClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/ThirdPerson/Blueprints/BP_ThirdPersonCharacter.BP_ThirdPersonCharacter_C")));
+
+	// used if the blueprint can't be loaded
+	DefaultPawnClass = AMenuSystemCharacter::StaticClass();
+
+	// Travel between our maps without tearing down the connections, the controllers and player states come along
+	bUseSeamlessTravel = true;
+}
+
+void AMenuSystemGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	if(DefaultPawnSoftClass.IsNull()){
+		return;
+	}
+
+	//already in memory, e.g. preloaded before the travel or kept from the previous map
+	if(UClass* LoadedClass = DefaultPawnSoftClass.Get()){
+		DefaultPawnClass = LoadedClass;
+		return;
+	}
+
+	DefaultPawnClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(DefaultPawnSoftClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &ThisClass::OnDefaultPawnClassLoaded), FStreamableManager::AsyncLoadHighPriority);
+}
+
+void AMenuSystemGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	//the lobby (and any other map we serve) answers the reservation requests of joining players. Standalone maps, like the menu, have nobody to answer
+	const ENetMode NetMode = GetNetMode();
+	UMenuSystemSessionSubsystem* SessionSubsystem = GetSessionSubsystem();
+	if((NetMode == NM_ListenServer || NetMode == NM_DedicatedServer) && SessionSubsystem && SessionSubsystem->UsesReservationBeacons()){
+		ReservationBeaconHost = AMenuSystemReservationBeaconHostObject::StartHost(GetWorld(), ReservationHostObject);
+
+		//the port the beacon actually bound, which is not the configured one if another host on this machine took that. Without a beacon the session
+		//is advertised without a port, and players join it directly
+		SessionSubsystem->AdvertiseBeaconPort(ReservationBeaconHost ? ReservationBeaconHost->GetListenPort() : 0);
+	}
+}
+
+void AMenuSystemGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(ReservationBeaconHost){
+		ReservationBeaconHost->DestroyBeacon();
+		ReservationBeaconHost = nullptr;
+
+		//until the next map starts its own beacon (if it does), the session must not send players to a port nobody listens on
+		if(UMenuSystemSessionSubsystem* SessionSubsystem = GetSessionSubsystem()){
+			SessionSubsystem->AdvertiseBeaconPort(0);
+		}
+	}
+	ReservationHostObject = nullptr;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMenuSystemGameMode::PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+
+	//the game session only counts the players that are in, the slots promised through the beacon are kept for the players they were promised to
+	if(ErrorMessage.IsEmpty() && ReservationHostObject && !ReservationHostObject->HasSlotFor(UniqueId)){
+		ErrorMessage = TEXT("Server full.");
+	}
+}
+
+UMenuSystemSessionSubsystem* AMenuSystemGameMode::GetSessionSubsystem() const
+{
+	const UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UMenuSystemSessionSubsystem>() : nullptr;
+}
+
+void AMenuSystemGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	//the player holds their slot now, their reservation must not count a second time
+	if(ReservationHostObject && NewPlayer && NewPlayer->PlayerState){
+		ReservationHostObject->OnPlayerArrived(NewPlayer->PlayerState->GetUniqueId());
+	}
+}
+
+void AMenuSystemGameMode::RestartPlayer(AController* NewPlayer)
+{
+	//spawning now would give the player the fallback pawn, wait for the real one instead
+	if(DefaultPawnClassHandle.IsValid() && DefaultPawnClassHandle->IsLoadingInProgress()){
+		PendingRestartPlayers.AddUnique(NewPlayer);
+		return;
+	}
+
+	Super::RestartPlayer(NewPlayer);
+}
+
+void AMenuSystemGameMode::OnDefaultPawnClassLoaded()
+{
+	if(UClass* LoadedClass = DefaultPawnSoftClass.Get()){
+		DefaultPawnClass = LoadedClass;
+	}
+	else{
+		UE_LOG(LogMenuSystem, Warning, TEXT("Could not load the pawn class %s, players get %s"), *DefaultPawnSoftClass.ToString(), *GetNameSafe(DefaultPawnClass));
+	}
+
+	//the game mode keeps the class alive through DefaultPawnClass from now on
+	DefaultPawnClassHandle.Reset();
+
+	TArray<TWeakObjectPtr<AController>> PlayersToRestart = MoveTemp(PendingRestartPlayers);
+	for(const TWeakObjectPtr<AController>& Player : PlayersToRestart)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		//the player may have left, or been given a pawn some other way while we waited
+		if(Player.IsValid() && Player->GetPawn() == nullptr){
+			RestartPlayer(Player.Get());
+		}
 	}
 }
@@ -6,13 +6,54 @@
 #include "GameFramework/GameModeBase.h"
 #include "MenuSystemGameMode.generated.h"
 
-UCLASS(minimalapi)
+class AOnlineBeaconHost;
+class AMenuSystemReservationBeaconHostObject;
+class UMenuSystemSessionSubsystem;
+struct FStreamableHandle;
+
+UCLASS(minimalapi, config=Game)
 class AMenuSystemGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AMenuSystemGameMode();
+
+	// AGameModeBase interface
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void PreLogin(const FString& Options, const FString& Address, const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
+	virtual void RestartPlayer(AController* NewPlayer) override;
+	virtual void StartPlay() override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	// End of AGameModeBase interface
+
+	// AActor interface
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	// End of AActor interface
+
+	/** Pawn spawned for the players. Streamed in when the game starts instead of being loaded with the game mode, players joining before it is in memory spawn once it is */
+	UPROPERTY(EditDefaultsOnly, Config, Category=Classes)
+	TSoftClassPtr<APawn> DefaultPawnSoftClass;
+
+private:
+	/** Returns the session subsystem of our game instance, if there is one */
+	UMenuSystemSessionSubsystem* GetSessionSubsystem() const;
+
+	/** Called when DefaultPawnSoftClass is loaded (or failed to load), spawns the players that were waiting for it */
+	void OnDefaultPawnClassLoaded();
+
+	// Keeps the pawn class loaded while the load is in flight.
+	TSharedPtr<FStreamableHandle> DefaultPawnClassHandle;
+
+	// Players that asked for a pawn before its class was loaded.
+	TArray<TWeakObjectPtr<AController>> PendingRestartPlayers;
+
+	// Beacon joining players reserve their slot through before they travel, only while we are a server.
+	UPROPERTY(Transient)
+	AOnlineBeaconHost* ReservationBeaconHost = nullptr;
+
+	UPROPERTY(Transient)
+	AMenuSystemReservationBeaconHostObject* ReservationHostObject = nullptr;
 };
 
 
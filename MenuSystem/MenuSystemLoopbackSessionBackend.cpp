@@ -0,0 +1,420 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemLoopbackSessionBackend.h"
+#include "MenuSystemSessionQuery.h"
+#include "MenuSystemSessionStats.h"
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystemTypes.h"
+
+const FName FMenuSystemLoopbackSessionBackend::BackendName(TEXT("Loopback"));
+int32 FMenuSystemLoopbackSessionBackend::NextHostedSessionId = 0;
+
+namespace MenuSystemLoopback
+{
+	/** Session info of loopback sessions, only carries the session id and the address to travel to */
+	class FSessionInfo : public FOnlineSessionInfo
+	{
+	public:
+		FSessionInfo(const FString& InSessionId, const FString& InHostAddress):
+			SessionId(FUniqueNetIdString::Create(InSessionId, FMenuSystemLoopbackSessionBackend::BackendName)),
+			HostAddress(InHostAddress)
+		{
+		}
+
+		virtual const uint8* GetBytes() const override { return nullptr; }
+		virtual int32 GetSize() const override { return 0; }
+		virtual bool IsValid() const override { return true; }
+		virtual FString ToString() const override { return SessionId->ToString(); }
+		virtual FString ToDebugString() const override { return FString::Printf(TEXT("SessionId: %s HostAddress: %s"), *SessionId->ToString(), *HostAddress); }
+		virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+
+		FUniqueNetIdRef SessionId;
+		FString HostAddress;
+	};
+
+	/** Every loopback backend of the process, so searches can see the sessions hosted by the others */
+	TArray<TWeakPtr<FMenuSystemLoopbackSessionBackend>>& GetBackends()
+	{
+		static TArray<TWeakPtr<FMenuSystemLoopbackSessionBackend>> Backends;
+		return Backends;
+	}
+
+	/** Session ids of hosted sessions start with this, the made up ones of the searches don't */
+	const TCHAR* const HostedSessionIdPrefix = TEXT("Loopback_");
+
+	bool ToDouble(const FVariantData& Data, double& OutValue)
+	{
+		switch(Data.GetType())
+		{
+		case EOnlineKeyValuePairDataType::Int32: { int32 Value; Data.GetValue(Value); OutValue = Value; return true; }
+		case EOnlineKeyValuePairDataType::UInt32: { uint32 Value; Data.GetValue(Value); OutValue = Value; return true; }
+		case EOnlineKeyValuePairDataType::Int64: { int64 Value; Data.GetValue(Value); OutValue = Value; return true; }
+		case EOnlineKeyValuePairDataType::UInt64: { uint64 Value; Data.GetValue(Value); OutValue = Value; return true; }
+		case EOnlineKeyValuePairDataType::Float: { float Value; Data.GetValue(Value); OutValue = Value; return true; }
+		case EOnlineKeyValuePairDataType::Double: { Data.GetValue(OutValue); return true; }
+		default: return false;
+		}
+	}
+
+	bool Compare(const FVariantData& SessionValue, const FVariantData& QueryValue, EOnlineComparisonOp::Type ComparisonOp)
+	{
+		if(ComparisonOp == EOnlineComparisonOp::Equals){
+			return SessionValue == QueryValue;
+		}
+		if(ComparisonOp == EOnlineComparisonOp::NotEquals){
+			return SessionValue != QueryValue;
+		}
+
+		double SessionNumber = 0.;
+		double QueryNumber = 0.;
+		if(!ToDouble(SessionValue, SessionNumber) || !ToDouble(QueryValue, QueryNumber)){
+			return false;
+		}
+
+		switch(ComparisonOp)
+		{
+		case EOnlineComparisonOp::GreaterThan: return SessionNumber > QueryNumber;
+		case EOnlineComparisonOp::GreaterThanEquals: return SessionNumber >= QueryNumber;
+		case EOnlineComparisonOp::LessThan: return SessionNumber < QueryNumber;
+		case EOnlineComparisonOp::LessThanEquals: return SessionNumber <= QueryNumber;
+		default: return true;		//ordering hints (Near, In, ...) don't filter
+		}
+	}
+}
+
+FMenuSystemLoopbackSessionBackend::FMenuSystemLoopbackSessionBackend(const FMenuSystemLoopbackSettings& InSettings):
+	Settings(InSettings),
+	RandomStream(InSettings.RandomSeed)
+{
+}
+
+FMenuSystemLoopbackSessionBackend::~FMenuSystemLoopbackSessionBackend()
+{
+	for(const TPair<int32, FTSTicker::FDelegateHandle>& Operation : PendingOperations)
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(Operation.Value);
+	}
+
+	MenuSystemLoopback::GetBackends().RemoveAll([this](const TWeakPtr<FMenuSystemLoopbackSessionBackend>& Backend) { return !Backend.IsValid() || Backend.Pin().Get() == this; });
+}
+
+float FMenuSystemLoopbackSessionBackend::Schedule(TFunction<void()>&& Operation, float MaxDelaySeconds)
+{
+	//register lazily, AsShared() can't be used in the constructor
+	TArray<TWeakPtr<FMenuSystemLoopbackSessionBackend>>& Backends = MenuSystemLoopback::GetBackends();
+	if(!Backends.ContainsByPredicate([this](const TWeakPtr<FMenuSystemLoopbackSessionBackend>& Backend) { return Backend.Pin().Get() == this; })){
+		Backends.Add(AsShared());
+	}
+
+	const float DelaySeconds = FMath::Max(0.f, Settings.LatencyMs + RandomStream.FRandRange(0.f, Settings.LatencyJitterMs)) / 1000.f;
+	const float TickerDelaySeconds = MaxDelaySeconds >= 0.f ? FMath::Min(DelaySeconds, MaxDelaySeconds) : DelaySeconds;
+	const int32 OperationId = NextOperationId++;
+
+	TWeakPtr<FMenuSystemLoopbackSessionBackend> WeakThis = AsShared();
+	PendingOperations.Add(OperationId, FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+		[WeakThis, OperationId, Operation = MoveTemp(Operation)](float)
+		{
+			if(TSharedPtr<FMenuSystemLoopbackSessionBackend> This = WeakThis.Pin()){
+				//we stand in for the online service, what it allocates for a search is part of what a search costs
+				LLM_SCOPE_BYTAG(MenuSystemSession);
+				This->PendingOperations.Remove(OperationId);
+				Operation();
+			}
+			return false;		//one shot
+		}), TickerDelaySeconds));
+
+	return DelaySeconds;
+}
+
+bool FMenuSystemLoopbackSessionBackend::ShouldFail()
+{
+	return Settings.FailureRate > 0.f && RandomStream.FRand() < Settings.FailureRate;
+}
+
+bool FMenuSystemLoopbackSessionBackend::HasNamedSession(FName SessionName) const
+{
+	return NamedSessions.Contains(SessionName);
+}
+
+bool FMenuSystemLoopbackSessionBackend::CreateSession(const FUniqueNetIdRepl& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+	//like the online subsystems, a session name can only be used once
+	if(NamedSessions.Contains(SessionName)){
+		return false;
+	}
+
+	const bool bFail = ShouldFail();
+	FNamedSession& NamedSession = NamedSessions.Add(SessionName);
+	NamedSession.bHosting = true;
+	NamedSession.Session = FOnlineSession(NewSessionSettings);
+	NamedSession.Session.OwningUserName = HostingPlayerId.IsValid() ? HostingPlayerId.ToString() : FString::Printf(TEXT("LoopbackHost%d"), NextHostedSessionId);
+	NamedSession.Session.NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
+	NamedSession.Session.SessionInfo = MakeShared<MenuSystemLoopback::FSessionInfo>(FString::Printf(TEXT("%s%d"), MenuSystemLoopback::HostedSessionIdPrefix, NextHostedSessionId++), Settings.ConnectAddress);
+
+	Schedule([this, SessionName, bFail]()
+	{
+		if(bFail){
+			NamedSessions.Remove(SessionName);
+		}
+		TriggerOnCreateSessionCompleteDelegates(SessionName, !bFail);
+	});
+	return true;
+}
+
+bool FMenuSystemLoopbackSessionBackend::DestroySession(FName SessionName)
+{
+	if(!NamedSessions.Contains(SessionName)){
+		return false;
+	}
+
+	//the session is gone for searches right away, only the completion is delayed
+	NamedSessions.Remove(SessionName);
+	Schedule([this, SessionName]()
+	{
+		TriggerOnDestroySessionCompleteDelegates(SessionName, true);
+	});
+	return true;
+}
+
+bool FMenuSystemLoopbackSessionBackend::FindSessions(const FUniqueNetIdRepl& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	if(PendingSearch.IsValid()){
+		return false;		//one search at a time, like the online subsystems
+	}
+
+	PendingSearch = SearchSettings;
+	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+	SearchSettings->SearchResults.Reset();
+
+	const bool bFail = ShouldFail();
+	const float MaxDelaySeconds = SearchSettings->TimeoutInSeconds > 0.f ? SearchSettings->TimeoutInSeconds : -1.f;
+	const float DelaySeconds = Schedule([this, SearchSettings, bFail]()
+	{
+		//a cancelled search never completes
+		if(PendingSearch.Get() != &SearchSettings.Get()){
+			return;
+		}
+		PendingSearch.Reset();
+
+		const bool bTimedOut = SearchSettings->TimeoutInSeconds > 0.f && SearchSettings->SearchState == EOnlineAsyncTaskState::Failed;
+		if(bFail || bTimedOut){
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+			TriggerOnFindSessionsCompleteDelegates(false);
+			return;
+		}
+
+		//sessions hosted by the loopback backends of this process first, then the made up ones
+		for(const TWeakPtr<FMenuSystemLoopbackSessionBackend>& WeakBackend : MenuSystemLoopback::GetBackends())
+		{
+			const TSharedPtr<FMenuSystemLoopbackSessionBackend> Backend = WeakBackend.Pin();
+			if(!Backend.IsValid() || Backend.Get() == this){
+				continue;
+			}
+			for(const TPair<FName, FNamedSession>& NamedSession : Backend->NamedSessions)
+			{
+				if(SearchSettings->SearchResults.Num() >= SearchSettings->MaxSearchResults){
+					break;
+				}
+				if(NamedSession.Value.bHosting && NamedSession.Value.Session.SessionSettings.bShouldAdvertise && PassesQuery(NamedSession.Value.Session, *SearchSettings)){
+					SearchSettings->SearchResults.Add(MakeSearchResult(NamedSession.Value.Session, FMath::RoundToInt(Settings.LatencyMs)));
+				}
+			}
+		}
+
+		for(int32 Index = 0; Index < Settings.SyntheticSessionCount && SearchSettings->SearchResults.Num() < SearchSettings->MaxSearchResults; ++Index)
+		{
+			//every made up session is derived from its index only, so it is the same session in every search
+			FRandomStream SessionStream(Settings.RandomSeed + Index);
+
+			FOnlineSessionSettings SyntheticSettings;
+			SyntheticSettings.NumPublicConnections = 4 << SessionStream.RandRange(0, 4);
+			SyntheticSettings.bShouldAdvertise = true;
+			SyntheticSettings.bIsLANMatch = false;		//advertised online, a LAN search only finds the hosted LAN sessions
+			SyntheticSettings.bUsesPresence = true;
+			SyntheticSettings.bAllowJoinInProgress = true;
+			FMenuSystemSessionQuery()
+				.WithMatchType(SessionStream.FRand() < 0.75f ? TEXT("FreeForAll") : TEXT("TeamDeathMatch"))
+				.WithLocalBuildVersion()
+				.AdvertiseIn(SyntheticSettings);
+
+			FOnlineSession SyntheticSession(SyntheticSettings);
+			SyntheticSession.OwningUserName = FString::Printf(TEXT("SyntheticHost%d"), Index);
+			SyntheticSession.NumOpenPublicConnections = SessionStream.RandRange(0, SyntheticSettings.NumPublicConnections);
+			SyntheticSession.SessionInfo = MakeShared<MenuSystemLoopback::FSessionInfo>(FString::Printf(TEXT("Synthetic_%d"), Index), Settings.ConnectAddress);
+
+			if(PassesQuery(SyntheticSession, *SearchSettings)){
+				SearchSettings->SearchResults.Add(MakeSearchResult(SyntheticSession, SessionStream.RandRange(10, 300)));
+			}
+		}
+
+		SearchSettings->SearchState = EOnlineAsyncTaskState::Done;
+		TriggerOnFindSessionsCompleteDelegates(true);
+	}, MaxDelaySeconds);
+
+	//the search is cut short at its time budget, flag it now so the completion reports the timeout
+	if(SearchSettings->TimeoutInSeconds > 0.f && DelaySeconds > SearchSettings->TimeoutInSeconds){
+		SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+	}
+	return true;
+}
+
+bool FMenuSystemLoopbackSessionBackend::CancelFindSessions()
+{
+	if(!PendingSearch.IsValid()){
+		return false;
+	}
+	PendingSearch->SearchState = EOnlineAsyncTaskState::Failed;
+	PendingSearch.Reset();
+	return true;
+}
+
+bool FMenuSystemLoopbackSessionBackend::JoinSession(const FUniqueNetIdRepl& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+	if(NamedSessions.Contains(SessionName) || !DesiredSession.Session.SessionInfo.IsValid()){
+		return false;
+	}
+
+	const FString SessionId = DesiredSession.GetSessionIdStr();
+	const bool bFail = ShouldFail();
+	Schedule([this, SessionName, SessionId, DesiredSession, bFail]()
+	{
+		if(bFail){
+			TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::UnknownError);
+			return;
+		}
+
+		//take a slot of the hosted session
+		FOnlineSession* HostedSession = nullptr;
+		for(const TWeakPtr<FMenuSystemLoopbackSessionBackend>& WeakBackend : MenuSystemLoopback::GetBackends())
+		{
+			const TSharedPtr<FMenuSystemLoopbackSessionBackend> Backend = WeakBackend.Pin();
+			if(!Backend.IsValid()){
+				continue;
+			}
+			for(TPair<FName, FNamedSession>& NamedSession : Backend->NamedSessions)
+			{
+				if(NamedSession.Value.bHosting && NamedSession.Value.Session.GetSessionIdStr() == SessionId){
+					HostedSession = &NamedSession.Value.Session;
+					break;
+				}
+			}
+			if(HostedSession){
+				break;
+			}
+		}
+
+		if(HostedSession){
+			if(HostedSession->NumOpenPublicConnections <= 0){
+				TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::SessionIsFull);
+				return;
+			}
+			--HostedSession->NumOpenPublicConnections;
+		}
+		else if(SessionId.StartsWith(MenuSystemLoopback::HostedSessionIdPrefix)){
+			//the host destroyed the session (or went away) since the search
+			TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::SessionDoesNotExist);
+			return;
+		}
+		else if(DesiredSession.Session.NumOpenPublicConnections <= 0){
+			//made up sessions are only full if the search said so
+			TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::SessionIsFull);
+			return;
+		}
+
+		FNamedSession& NamedSession = NamedSessions.Add(SessionName);
+		NamedSession.Session = DesiredSession.Session;
+		NamedSession.bHosting = false;
+		TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::Success);
+	});
+	return true;
+}
+
+FOnlineSessionSettings* FMenuSystemLoopbackSessionBackend::GetSessionSettings(FName SessionName)
+{
+	FNamedSession* NamedSession = NamedSessions.Find(SessionName);
+	return NamedSession ? &NamedSession->Session.SessionSettings : nullptr;
+}
+
+bool FMenuSystemLoopbackSessionBackend::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings)
+{
+	FNamedSession* NamedSession = NamedSessions.Find(SessionName);
+	if(NamedSession == nullptr || !NamedSession->bHosting){
+		return false;
+	}
+
+	//the searches of the other backends read the hosted sessions directly, they see the new settings right away
+	NamedSession->Session.SessionSettings = UpdatedSessionSettings;
+	return true;
+}
+
+bool FMenuSystemLoopbackSessionBackend::GetResolvedConnectString(FName SessionName, FString& ConnectInfo)
+{
+	const FNamedSession* NamedSession = NamedSessions.Find(SessionName);
+	if(NamedSession == nullptr || !NamedSession->Session.SessionInfo.IsValid()){
+		return false;
+	}
+	ConnectInfo = StaticCastSharedPtr<MenuSystemLoopback::FSessionInfo>(NamedSession->Session.SessionInfo)->HostAddress;
+	return true;
+}
+
+bool FMenuSystemLoopbackSessionBackend::GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo)
+{
+	if(!SearchResult.Session.SessionInfo.IsValid()){
+		return false;
+	}
+	ConnectInfo = StaticCastSharedPtr<MenuSystemLoopback::FSessionInfo>(SearchResult.Session.SessionInfo)->HostAddress;
+
+	//same host, other port
+	if(PortType == NAME_BeaconPort){
+		int32 BeaconPort = 0;
+		FString Host;
+		if(!SearchResult.Session.SessionSettings.Get(SETTING_BEACONPORT, BeaconPort) || !ConnectInfo.Split(TEXT(":"), &Host, nullptr, ESearchCase::CaseSensitive, ESearchDir::FromEnd)){
+			return false;
+		}
+		ConnectInfo = FString::Printf(TEXT("%s:%d"), *Host, BeaconPort);
+	}
+	return true;
+}
+
+FOnlineSessionSearchResult FMenuSystemLoopbackSessionBackend::MakeSearchResult(const FOnlineSession& Session, int32 PingInMs) const
+{
+	FOnlineSessionSearchResult SearchResult;
+	SearchResult.Session = Session;
+	SearchResult.PingInMs = PingInMs;
+	return SearchResult;
+}
+
+bool FMenuSystemLoopbackSessionBackend::PassesQuery(const FOnlineSession& Session, const FOnlineSessionSearch& Search)
+{
+	//like the online subsystems, a LAN search only reaches LAN sessions and an online search only online ones
+	if(Session.SessionSettings.bIsLANMatch != Search.bIsLanQuery){
+		return false;
+	}
+
+	for(const TPair<FName, FOnlineSessionSearchParam>& Param : Search.QuerySettings.SearchParams)
+	{
+		if(Param.Key == SEARCH_PRESENCE){
+			bool bPresence = false;
+			Param.Value.Data.GetValue(bPresence);
+			if(Session.SessionSettings.bUsesPresence != bPresence){
+				return false;
+			}
+			continue;
+		}
+
+		if(Param.Key == SEARCH_MINSLOTSAVAILABLE){
+			int32 MinSlots = 0;
+			Param.Value.Data.GetValue(MinSlots);
+			if(Session.NumOpenPublicConnections < MinSlots){
+				return false;
+			}
+			continue;
+		}
+
+		const FOnlineSessionSetting* Setting = Session.SessionSettings.Settings.Find(Param.Key);
+		if(Setting == nullptr || !MenuSystemLoopback::Compare(Setting->Data, Param.Value.Data, Param.Value.ComparisonOp)){
+			return false;
+		}
+	}
+	return true;
+}
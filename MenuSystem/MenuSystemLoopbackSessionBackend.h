@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "MenuSystemSessionBackend.h"
+
+/**
+ * In-process stand-in for an online backend. Hosted sessions are kept in memory and shared by every loopback backend of the process
+ * (e.g. PIE clients running in one process find each other), searches can add made up sessions, and every operation completes
+ * on the core ticker after a configurable latency, failing at a configurable rate. No Steam client or network is needed.
+ */
+class FMenuSystemLoopbackSessionBackend : public IMenuSystemSessionBackend, public TSharedFromThis<FMenuSystemLoopbackSessionBackend>
+{
+public:
+	explicit FMenuSystemLoopbackSessionBackend(const FMenuSystemLoopbackSettings& InSettings);
+	virtual ~FMenuSystemLoopbackSessionBackend();
+
+	static const FName BackendName;
+
+	// IMenuSystemSessionBackend interface
+	virtual FName GetBackendName() const override { return BackendName; }
+	virtual bool HasNamedSession(FName SessionName) const override;
+	virtual bool CreateSession(const FUniqueNetIdRepl& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool DestroySession(FName SessionName) override;
+	virtual bool FindSessions(const FUniqueNetIdRepl& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool JoinSession(const FUniqueNetIdRepl& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual FOnlineSessionSettings* GetSessionSettings(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings) override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override;
+	virtual bool GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo) override;
+	// End of IMenuSystemSessionBackend interface
+
+	/** Number of operations waiting for their simulated latency, lets headless drivers know when to stop ticking */
+	int32 GetNumPendingOperations() const { return PendingOperations.Num(); }
+
+private:
+	/** Runs Operation once the simulated latency (capped to MaxDelaySeconds if not negative) has passed. Returns the uncapped latency */
+	float Schedule(TFunction<void()>&& Operation, float MaxDelaySeconds = -1.f);
+
+	/** Rolls the dice against Settings.FailureRate */
+	bool ShouldFail();
+
+	/** Builds a search result for a hosted or made up session */
+	FOnlineSessionSearchResult MakeSearchResult(const FOnlineSession& Session, int32 PingInMs) const;
+
+	/** Returns true if the session is of the kind searched for (LAN or online) and passes every key of the search's QuerySettings */
+	static bool PassesQuery(const FOnlineSession& Session, const FOnlineSessionSearch& Search);
+
+	// Unique across the process, so two backends never host sessions with the same id.
+	static int32 NextHostedSessionId;
+
+	FMenuSystemLoopbackSettings Settings;
+	FRandomStream RandomStream;
+
+	struct FNamedSession
+	{
+		FOnlineSession Session;
+		bool bHosting = false;
+	};
+
+	// Sessions this backend hosts or has joined, by session name. Hosted ones are found by the searches of every loopback backend.
+	TMap<FName, FNamedSession> NamedSessions;
+
+	// Search waiting for its results, cleared by CancelFindSessions.
+	TSharedPtr<FOnlineSessionSearch> PendingSearch;
+
+	// Ticker handles of the operations waiting for their simulated latency, by operation id.
+	TMap<int32, FTSTicker::FDelegateHandle> PendingOperations;
+	int32 NextOperationId = 0;
+};
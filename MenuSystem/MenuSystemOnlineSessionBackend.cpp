@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemOnlineSessionBackend.h"
+#include "OnlineSubsystem.h"
+
+FMenuSystemOnlineSessionBackend::FMenuSystemOnlineSessionBackend(FName InSubsystemName, IOnlineSessionPtr InSessionInterface):
+	SubsystemName(InSubsystemName),
+	SessionInterface(InSessionInterface)
+{
+	check(SessionInterface.IsValid());
+
+	//forward the session interface completions to our own delegate lists
+	CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(FOnCreateSessionCompleteDelegate::CreateRaw(this, &FMenuSystemOnlineSessionBackend::TriggerOnCreateSessionCompleteDelegates));
+	DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(FOnDestroySessionCompleteDelegate::CreateRaw(this, &FMenuSystemOnlineSessionBackend::TriggerOnDestroySessionCompleteDelegates));
+	FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateRaw(this, &FMenuSystemOnlineSessionBackend::TriggerOnFindSessionsCompleteDelegates));
+	JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateRaw(this, &FMenuSystemOnlineSessionBackend::TriggerOnJoinSessionCompleteDelegates));
+}
+
+FMenuSystemOnlineSessionBackend::~FMenuSystemOnlineSessionBackend()
+{
+	SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+	SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+	SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+}
+
+TSharedPtr<IMenuSystemSessionBackend> FMenuSystemOnlineSessionBackend::Create(FName SubsystemName)
+{
+	IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get(SubsystemName);
+	if(OnlineSubsystem == nullptr){
+		return nullptr;
+	}
+
+	IOnlineSessionPtr SessionInterface = OnlineSubsystem->GetSessionInterface();
+	if(!SessionInterface.IsValid()){
+		return nullptr;
+	}
+	return MakeShared<FMenuSystemOnlineSessionBackend>(OnlineSubsystem->GetSubsystemName(), SessionInterface);
+}
+
+bool FMenuSystemOnlineSessionBackend::HasNamedSession(FName SessionName) const
+{
+	return SessionInterface->GetNamedSession(SessionName) != nullptr;
+}
+
+bool FMenuSystemOnlineSessionBackend::CreateSession(const FUniqueNetIdRepl& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+	if(HostingPlayerId.IsValid()){
+		return SessionInterface->CreateSession(*HostingPlayerId, SessionName, NewSessionSettings);
+	}
+	return SessionInterface->CreateSession(0, SessionName, NewSessionSettings);
+}
+
+bool FMenuSystemOnlineSessionBackend::DestroySession(FName SessionName)
+{
+	return SessionInterface->DestroySession(SessionName);
+}
+
+bool FMenuSystemOnlineSessionBackend::FindSessions(const FUniqueNetIdRepl& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	if(SearchingPlayerId.IsValid()){
+		return SessionInterface->FindSessions(*SearchingPlayerId, SearchSettings);
+	}
+	return SessionInterface->FindSessions(0, SearchSettings);
+}
+
+bool FMenuSystemOnlineSessionBackend::CancelFindSessions()
+{
+	return SessionInterface->CancelFindSessions();
+}
+
+bool FMenuSystemOnlineSessionBackend::JoinSession(const FUniqueNetIdRepl& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+	if(PlayerId.IsValid()){
+		return SessionInterface->JoinSession(*PlayerId, SessionName, DesiredSession);
+	}
+	return SessionInterface->JoinSession(0, SessionName, DesiredSession);
+}
+
+FOnlineSessionSettings* FMenuSystemOnlineSessionBackend::GetSessionSettings(FName SessionName)
+{
+	return SessionInterface->GetSessionSettings(SessionName);
+}
+
+bool FMenuSystemOnlineSessionBackend::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings)
+{
+	return SessionInterface->UpdateSession(SessionName, UpdatedSessionSettings, true);
+}
+
+bool FMenuSystemOnlineSessionBackend::GetResolvedConnectString(FName SessionName, FString& ConnectInfo)
+{
+	return SessionInterface->GetResolvedConnectString(SessionName, ConnectInfo);
+}
+
+bool FMenuSystemOnlineSessionBackend::GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo)
+{
+	return SessionInterface->GetResolvedConnectString(SearchResult, PortType, ConnectInfo);
+}
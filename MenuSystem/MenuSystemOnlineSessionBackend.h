@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MenuSystemSessionBackend.h"
+
+/** Session backend forwarding to the session interface of an online subsystem (Steam, Null, ...). */
+class FMenuSystemOnlineSessionBackend : public IMenuSystemSessionBackend
+{
+public:
+	FMenuSystemOnlineSessionBackend(FName InSubsystemName, IOnlineSessionPtr InSessionInterface);
+	virtual ~FMenuSystemOnlineSessionBackend();
+
+	/** Creates a backend for the named online subsystem (the default one if NAME_None), or returns nullptr if it has no session interface */
+	static TSharedPtr<IMenuSystemSessionBackend> Create(FName SubsystemName = NAME_None);
+
+	// IMenuSystemSessionBackend interface
+	virtual FName GetBackendName() const override { return SubsystemName; }
+	virtual bool HasNamedSession(FName SessionName) const override;
+	virtual bool CreateSession(const FUniqueNetIdRepl& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool DestroySession(FName SessionName) override;
+	virtual bool FindSessions(const FUniqueNetIdRepl& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool JoinSession(const FUniqueNetIdRepl& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual FOnlineSessionSettings* GetSessionSettings(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings) override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) override;
+	virtual bool GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo) override;
+	// End of IMenuSystemSessionBackend interface
+
+private:
+	FName SubsystemName;
+	IOnlineSessionPtr SessionInterface;
+
+	// Our delegates stay registered on the session interface for the lifetime of the backend and re-trigger ours.
+	FDelegateHandle CreateSessionCompleteDelegateHandle;
+	FDelegateHandle DestroySessionCompleteDelegateHandle;
+	FDelegateHandle FindSessionsCompleteDelegateHandle;
+	FDelegateHandle JoinSessionCompleteDelegateHandle;
+};
@@ -0,0 +1,340 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemReplicationGraph.h"
+#include "Algo/AnyOf.h"
+#include "Engine/ChildConnection.h"
+#include "Engine/LevelScriptActor.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<int32> CVarMenuSystemReplicationGraphEnable(
+	TEXT("MenuSystem.ReplicationGraph.Enable"),
+	1,
+	TEXT("Use UMenuSystemReplicationGraph for the game net driver. Read when the net driver is created, e.g. on the next listen."),
+	ECVF_Default
+);
+
+bool UMenuSystemReplicationGraph::IsEnabled()
+{
+	return CVarMenuSystemReplicationGraphEnable.GetValueOnAnyThread() != 0;
+}
+
+EMenuSystemClassRepNodeMapping UMenuSystemReplicationGraph::GetMappingPolicy(UClass* Class) const
+{
+	const EMenuSystemClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class);
+	return Policy ? *Policy : EMenuSystemClassRepNodeMapping::NotRouted;
+}
+
+void UMenuSystemReplicationGraph::InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const
+{
+	const AActor* ActorCDO = CastChecked<AActor>(Class->GetDefaultObject());
+	if(bSpatialize){
+		Info.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+	}
+	Info.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->NetUpdateFrequency);
+}
+
+void UMenuSystemReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	//explicit routing, inherited by the subclasses. Everything else is derived from the class defaults below
+	const TPair<UClass*, EMenuSystemClassRepNodeMapping> ExplicitPolicies[] = {
+		{ ALevelScriptActor::StaticClass(), EMenuSystemClassRepNodeMapping::NotRouted },
+		{ APlayerController::StaticClass(), EMenuSystemClassRepNodeMapping::NotRouted },
+		{ APlayerState::StaticClass(), EMenuSystemClassRepNodeMapping::PlayerState },
+		{ AInfo::StaticClass(), EMenuSystemClassRepNodeMapping::RelevantAllConnections },
+		{ ACharacter::StaticClass(), EMenuSystemClassRepNodeMapping::Spatialize_Dynamic },
+	};
+	for(const TPair<UClass*, EMenuSystemClassRepNodeMapping>& ExplicitPolicy : ExplicitPolicies)
+	{
+		ClassRepNodePolicies.Set(ExplicitPolicy.Key, ExplicitPolicy.Value);
+	}
+
+	TArray<UClass*> ReplicatedClasses;
+	for(TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if(ActorCDO == nullptr || !ActorCDO->GetIsReplicated()){
+			continue;
+		}
+
+		//leftovers of blueprint compilation
+		if(Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_"))){
+			continue;
+		}
+
+		ReplicatedClasses.Add(Class);
+
+		//infos are relevant to all connections, except the ones that are only relevant to their owner (or use their owner's relevancy)
+		if(Class->IsChildOf(AInfo::StaticClass()) && (ActorCDO->bOnlyRelevantToOwner || ActorCDO->bNetUseOwnerRelevancy)){
+			ClassRepNodePolicies.Set(Class, EMenuSystemClassRepNodeMapping::RelevantToOwner);
+			continue;
+		}
+
+		//subclasses of the explicit classes above inherit their policy
+		const bool bHasExplicitPolicy = Algo::AnyOf(ExplicitPolicies, [Class](const TPair<UClass*, EMenuSystemClassRepNodeMapping>& ExplicitPolicy){
+			return Class->IsChildOf(ExplicitPolicy.Key);
+		});
+		if(bHasExplicitPolicy){
+			continue;
+		}
+
+		if(ActorCDO->bAlwaysRelevant && !ActorCDO->bOnlyRelevantToOwner){
+			ClassRepNodePolicies.Set(Class, EMenuSystemClassRepNodeMapping::RelevantAllConnections);
+		}
+		else if(ActorCDO->bOnlyRelevantToOwner || ActorCDO->bNetUseOwnerRelevancy){
+			ClassRepNodePolicies.Set(Class, EMenuSystemClassRepNodeMapping::RelevantToOwner);
+		}
+		else if(ActorCDO->NetDormancy > DORM_Awake){
+			ClassRepNodePolicies.Set(Class, EMenuSystemClassRepNodeMapping::Spatialize_Dormancy);
+		}
+		else{
+			ClassRepNodePolicies.Set(Class, EMenuSystemClassRepNodeMapping::Spatialize_Dynamic);
+		}
+	}
+
+	//characters: culled by distance and prioritized per connection by distance and starvation. Their channel stays open
+	//for a few frames after they left the connection's cells, and they never go dormant, the owning client's moves use the channel
+	FClassReplicationInfo CharacterInfo;
+	InitClassReplicationInfo(CharacterInfo, ACharacter::StaticClass(), true);
+	CharacterInfo.SetCullDistanceSquared(CharacterCullDistance * CharacterCullDistance);
+	CharacterInfo.DistancePriorityScale = 1.f;
+	CharacterInfo.StarvationPriorityScale = 1.f;
+	CharacterInfo.ActorChannelFrameTimeout = CharacterChannelFrameTimeout;
+	GlobalActorReplicationInfoMap.SetClassInfo(ACharacter::StaticClass(), CharacterInfo);
+
+	for(UClass* Class : ReplicatedClasses)
+	{
+		if(Class->IsChildOf(ACharacter::StaticClass())){
+			continue;
+		}
+
+		const EMenuSystemClassRepNodeMapping Policy = GetMappingPolicy(Class);
+		FClassReplicationInfo ClassInfo;
+		InitClassReplicationInfo(ClassInfo, Class, Policy == EMenuSystemClassRepNodeMapping::Spatialize_Dynamic || Policy == EMenuSystemClassRepNodeMapping::Spatialize_Dormancy);
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+
+	//destruction of actors far away from a connection is sent once it comes close, not to everybody right away
+	DestructInfoMaxDistanceSquared = CharacterCullDistance * CharacterCullDistance;
+}
+
+void UMenuSystemReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	//with 64 players, checking every player state every frame costs more than their (rarely changing) data is worth
+	PlayerStateNodeSettings.NumBuckets = FMath::Max(PlayerStateFrequencyBuckets, 1);
+	PlayerStateNode = CreateNewNode<UReplicationGraphNode_ActorListFrequencyBuckets>();
+	PlayerStateNode->Settings = &PlayerStateNodeSettings;
+	AddGlobalGraphNode(PlayerStateNode);
+
+	OwnerRelevantNode = CreateNewNode<UMenuSystemReplicationGraphNode_OwnerRelevant>();
+	AddGlobalGraphNode(OwnerRelevantNode);
+}
+
+void UMenuSystemReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	//the connection's own player controller and view target (its pawn), whatever the grid says
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+void UMenuSystemReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch(GetMappingPolicy(ActorInfo.Class))
+	{
+		case EMenuSystemClassRepNodeMapping::RelevantAllConnections:
+			//actors of streaming levels must only go to the clients that loaded the level, the grid takes care of that
+			if(ActorInfo.StreamingLevelName == NAME_None){
+				AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+			}
+			else{
+				GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			}
+			break;
+
+		case EMenuSystemClassRepNodeMapping::PlayerState:
+			PlayerStateNode->NotifyAddNetworkActor(ActorInfo);
+			break;
+
+		case EMenuSystemClassRepNodeMapping::RelevantToOwner:
+			OwnerRelevantNode->NotifyAddNetworkActor(ActorInfo);
+			break;
+
+		case EMenuSystemClassRepNodeMapping::Spatialize_Dynamic:
+			GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			break;
+
+		case EMenuSystemClassRepNodeMapping::Spatialize_Dormancy:
+			GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			break;
+
+		default:
+			break;
+	}
+}
+
+void UMenuSystemReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch(GetMappingPolicy(ActorInfo.Class))
+	{
+		case EMenuSystemClassRepNodeMapping::RelevantAllConnections:
+			if(ActorInfo.StreamingLevelName == NAME_None){
+				AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+			}
+			else{
+				GridNode->RemoveActor_Dynamic(ActorInfo);
+			}
+			break;
+
+		case EMenuSystemClassRepNodeMapping::PlayerState:
+			PlayerStateNode->NotifyRemoveNetworkActor(ActorInfo);
+			break;
+
+		case EMenuSystemClassRepNodeMapping::RelevantToOwner:
+			OwnerRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+			break;
+
+		case EMenuSystemClassRepNodeMapping::Spatialize_Dynamic:
+			GridNode->RemoveActor_Dynamic(ActorInfo);
+			break;
+
+		case EMenuSystemClassRepNodeMapping::Spatialize_Dormancy:
+			GridNode->RemoveActor_Dormancy(ActorInfo);
+			break;
+
+		default:
+			break;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UMenuSystemReplicationGraphNode_OwnerRelevant
+
+UMenuSystemReplicationGraphNode_OwnerRelevant::UMenuSystemReplicationGraphNode_OwnerRelevant()
+{
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UMenuSystemReplicationGraphNode_OwnerRelevant::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	AActor* Actor = ActorInfo.GetActor();
+	if(Actor->bOnlyRelevantToOwner){
+		OwnerOnlyActors.Add(Actor);
+		return;
+	}
+
+	TWeakObjectPtr<AActor>& Parent = DependentActorParents.Add(Actor);
+	UpdateDependency(Actor, Parent);
+}
+
+bool UMenuSystemReplicationGraphNode_OwnerRelevant::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	AActor* Actor = ActorInfo.GetActor();
+	if(OwnerOnlyActors.RemoveSingleSwap(Actor, false) > 0){
+		for(TPair<UNetConnection*, FActorRepListRefView>& ConnectionActors : OwnerOnlyActorsByConnection)
+		{
+			ConnectionActors.Value.RemoveFast(Actor);
+		}
+		return true;
+	}
+
+	TWeakObjectPtr<AActor> Parent;
+	if(DependentActorParents.RemoveAndCopyValue(Actor, Parent)){
+		if(AActor* ParentActor = Parent.Get()){
+			GraphGlobals->GlobalActorReplicationInfoMap->RemoveDependentActor(ParentActor, Actor);
+		}
+		return true;
+	}
+	return false;
+}
+
+void UMenuSystemReplicationGraphNode_OwnerRelevant::NotifyResetAllNetworkActors()
+{
+	//the dependencies go away with the global actor infos, which are reset along with the nodes
+	OwnerOnlyActors.Reset();
+	OwnerOnlyActorsByConnection.Reset();
+	DependentActorParents.Reset();
+}
+
+void UMenuSystemReplicationGraphNode_OwnerRelevant::PrepareForReplication()
+{
+	for(TPair<UNetConnection*, FActorRepListRefView>& ConnectionActors : OwnerOnlyActorsByConnection)
+	{
+		ConnectionActors.Value.Reset();
+	}
+
+	for(AActor* Actor : OwnerOnlyActors)
+	{
+		//not owned by a client (yet), relevant to nobody
+		UNetConnection* Connection = Actor->GetNetConnection();
+		if(Connection == nullptr){
+			continue;
+		}
+
+		//split screen players replicate through the connection of the first player
+		if(UChildConnection* ChildConnection = Connection->GetUChildConnection()){
+			Connection = ChildConnection->Parent;
+		}
+		OwnerOnlyActorsByConnection.FindOrAdd(Connection).Add(Actor);
+	}
+
+	//forget the connections that don't own anything any more, e.g. the ones that closed
+	for(auto It = OwnerOnlyActorsByConnection.CreateIterator(); It; ++It)
+	{
+		if(It.Value().Num() == 0){
+			It.RemoveCurrent();
+		}
+	}
+
+	for(TPair<AActor*, TWeakObjectPtr<AActor>>& DependentActor : DependentActorParents)
+	{
+		UpdateDependency(DependentActor.Key, DependentActor.Value);
+	}
+}
+
+void UMenuSystemReplicationGraphNode_OwnerRelevant::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	if(const FActorRepListRefView* ConnectionActors = OwnerOnlyActorsByConnection.Find(Params.ConnectionManager.NetConnection)){
+		Params.OutGatheredReplicationLists.AddReplicationActorList(*ConnectionActors);
+	}
+}
+
+void UMenuSystemReplicationGraphNode_OwnerRelevant::UpdateDependency(AActor* Actor, TWeakObjectPtr<AActor>& Parent) const
+{
+	//the graph only knows replicated actors, an actor whose owner isn't replicated (or has none) is relevant to nobody
+	AActor* Owner = Actor->GetOwner();
+	if(!IsValid(Owner) || !Owner->GetIsReplicated()){
+		Owner = nullptr;
+	}
+
+	AActor* PreviousOwner = Parent.Get();
+	if(PreviousOwner == Owner){
+		return;
+	}
+
+	FGlobalActorReplicationInfoMap& GlobalActorReplicationInfoMap = *GraphGlobals->GlobalActorReplicationInfoMap;
+	if(PreviousOwner){
+		GlobalActorReplicationInfoMap.RemoveDependentActor(PreviousOwner, Actor);
+	}
+	if(Owner){
+		GlobalActorReplicationInfoMap.AddDependentActor(Owner, Actor);
+	}
+	Parent = Owner;
+}
@@ -0,0 +1,127 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "MenuSystemReplicationGraph.generated.h"
+
+/** Where the actors of a class are routed in the graph */
+enum class EMenuSystemClassRepNodeMapping : uint8
+{
+	NotRouted,					// Not in the global graph, e.g. player controllers which the per connection node adds for their own connection
+	RelevantToOwner,			// bOnlyRelevantToOwner/bNetUseOwnerRelevancy actors, replicated to their owner's connection or along with their owner
+	RelevantAllConnections,		// Always relevant, e.g. the game state
+	PlayerState,				// Spread over frequency buckets, every client still receives every player state
+	Spatialize_Dynamic,			// Grid relevancy for actors that move, e.g. characters
+	Spatialize_Dormancy,		// Grid relevancy for classes that start dormant (NetDormancy), skipped until they are flushed
+};
+
+/**
+ * Actors whose relevancy comes from their owner, which the graph nodes have no notion of:
+ * - bOnlyRelevantToOwner actors (other than player controllers) are gathered for the connection that owns them,
+ * - bNetUseOwnerRelevancy actors are dependent actors of their owner, so they replicate to the connections it replicates to.
+ * Owners change after spawn (possession, pick ups), so the owner of every actor is looked up again each frame.
+ */
+UCLASS()
+class UMenuSystemReplicationGraphNode_OwnerRelevant : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UMenuSystemReplicationGraphNode_OwnerRelevant();
+
+	// UReplicationGraphNode interface
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// End of UReplicationGraphNode interface
+
+private:
+	/** Makes an actor a dependent actor of its current owner, and no longer one of its previous owner */
+	void UpdateDependency(AActor* Actor, TWeakObjectPtr<AActor>& Parent) const;
+
+	// The bOnlyRelevantToOwner actors, and the ones owned by each connection (rebuilt every frame).
+	TArray<AActor*> OwnerOnlyActors;
+	TMap<UNetConnection*, FActorRepListRefView> OwnerOnlyActorsByConnection;
+
+	// The bNetUseOwnerRelevancy actors, and the owner each one is currently a dependent actor of.
+	TMap<AActor*, TWeakObjectPtr<AActor>> DependentActorParents;
+};
+
+/**
+ * Replication graph of the game's net driver, so the host's replication cost grows with what each client can see
+ * rather than with the number of players in the lobby:
+ * - characters and other moving actors are only considered for connections near them, through a 2D spatial grid,
+ * - classes that start dormant (NetDormancy, none of the game's own do so far) go to the dormancy aware grid, which skips them
+ *   until they are flushed or woken up,
+ * - player states are spread over several frames instead of all being checked every frame,
+ * - actors only relevant to their owner go to the owner's connection, and actors using their owner's relevancy replicate along with it
+ *   (infos included, every other info is relevant to all connections),
+ * - every connection always gets its own player controller and pawn, and the rest is prioritized per connection by
+ *   distance to that connection's viewer and by how long an actor has been starved.
+ *
+ * Installed by the game module for NAME_GameNetDriver, MenuSystem.ReplicationGraph.Enable 0 falls back to the stock relevancy.
+ */
+UCLASS(Transient, config=Game)
+class UMenuSystemReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	// UReplicationGraph interface
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	// End of UReplicationGraph interface
+
+	/** Returns true if the game net driver should use this graph */
+	static bool IsEnabled();
+
+	/** Size of a grid cell. Actors are considered for a connection when they are in a cell near its viewer */
+	UPROPERTY(Config)
+	float GridCellSize = 10000.f;
+
+	/** Offset of the grid, it should be below the lowest X/Y of the maps so no actor is in the (slow) negative cells */
+	UPROPERTY(Config)
+	FVector2D GridSpatialBias = FVector2D(-150000.f, -150000.f);
+
+	/** Distance past which a character isn't replicated to a connection */
+	UPROPERTY(Config)
+	float CharacterCullDistance = 15000.f;
+
+	/** Frames a character's channel is kept open after it stopped being relevant, so walking along a cell border doesn't reopen it */
+	UPROPERTY(Config)
+	int32 CharacterChannelFrameTimeout = 4;
+
+	/** Number of frames the player states are spread over */
+	UPROPERTY(Config)
+	int32 PlayerStateFrequencyBuckets = 3;
+
+private:
+	EMenuSystemClassRepNodeMapping GetMappingPolicy(UClass* Class) const;
+
+	/** Fills a class info from the defaults of the class (update frequency and cull distance) */
+	void InitClassReplicationInfo(FClassReplicationInfo& Info, UClass* Class, bool bSpatialize) const;
+
+	TClassMap<EMenuSystemClassRepNodeMapping> ClassRepNodePolicies;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode = nullptr;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode = nullptr;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorListFrequencyBuckets* PlayerStateNode = nullptr;
+
+	UPROPERTY()
+	UMenuSystemReplicationGraphNode_OwnerRelevant* OwnerRelevantNode = nullptr;
+
+	// Settings the player state node points to, it doesn't own them.
+	UReplicationGraphNode_ActorListFrequencyBuckets::FSettings PlayerStateNodeSettings;
+};
@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemReservationBeacon.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/GameSession.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "OnlineBeaconHost.h"
+#include "MenuSystem.h"
+
+//////////////////////////////////////////////////////////////////////////
+// AMenuSystemReservationBeaconClient
+
+bool AMenuSystemReservationBeaconClient::RequestReservation(const FString& ConnectInfo, const FUniqueNetIdRepl& PlayerId)
+{
+	FURL URL(nullptr, *ConnectInfo, TRAVEL_Absolute);
+	if(!URL.Valid){
+		return false;
+	}
+
+	PendingPlayerId = PlayerId;
+	bResponded = false;
+	return InitClient(URL);
+}
+
+void AMenuSystemReservationBeaconClient::OnConnected()
+{
+	Super::OnConnected();
+
+	//the handshake is done, the host object answers with ClientReservationResponse
+	ServerRequestReservation(PendingPlayerId);
+}
+
+void AMenuSystemReservationBeaconClient::OnFailure()
+{
+	BroadcastResponse(EMenuSystemReservationResult::ConnectionFailed, 0, 0);
+
+	Super::OnFailure();
+}
+
+void AMenuSystemReservationBeaconClient::ServerRequestReservation_Implementation(const FUniqueNetIdRepl& PlayerId)
+{
+	int32 Occupancy = 0;
+	int32 Capacity = 0;
+	EMenuSystemReservationResult Result = EMenuSystemReservationResult::NotHosting;
+
+	if(AMenuSystemReservationBeaconHostObject* HostObject = Cast<AMenuSystemReservationBeaconHostObject>(GetBeaconOwner())){
+		Result = HostObject->ProcessReservationRequest(PlayerId, Occupancy, Capacity);
+	}
+	ClientReservationResponse(Result, Occupancy, Capacity);
+}
+
+void AMenuSystemReservationBeaconClient::ClientReservationResponse_Implementation(EMenuSystemReservationResult Result, int32 Occupancy, int32 Capacity)
+{
+	BroadcastResponse(Result, Occupancy, Capacity);
+}
+
+void AMenuSystemReservationBeaconClient::BroadcastResponse(EMenuSystemReservationResult Result, int32 Occupancy, int32 Capacity)
+{
+	//a failure can follow the answer when the host closes the connection
+	if(bResponded){
+		return;
+	}
+	bResponded = true;
+	OnReservationResponse.ExecuteIfBound(Result, Occupancy, Capacity);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AMenuSystemReservationBeaconHostObject
+
+AMenuSystemReservationBeaconHostObject::AMenuSystemReservationBeaconHostObject()
+{
+	ClientBeaconActorClass = AMenuSystemReservationBeaconClient::StaticClass();
+	BeaconTypeName = ClientBeaconActorClass->GetName();
+}
+
+int32 AMenuSystemReservationBeaconHostObject::GetBeaconPort()
+{
+	//the same override AOnlineBeaconHost::InitHost applies, so several hosts can run on one machine
+	int32 BeaconPort = GetDefault<AOnlineBeaconHost>()->ListenPort;
+	FParse::Value(FCommandLine::Get(), TEXT("BeaconPort="), BeaconPort);
+	return BeaconPort;
+}
+
+bool AMenuSystemReservationBeaconHostObject::IsBeaconNetDriverConfigured()
+{
+	static const FName BeaconNetDriverName(TEXT("BeaconNetDriver"));
+	return GEngine && GEngine->NetDriverDefinitions.ContainsByPredicate([](const FNetDriverDefinition& Definition){
+		return Definition.DefName == BeaconNetDriverName;
+	});
+}
+
+AOnlineBeaconHost* AMenuSystemReservationBeaconHostObject::StartHost(UWorld* World, AMenuSystemReservationBeaconHostObject*& OutHostObject)
+{
+	OutHostObject = nullptr;
+	if(World == nullptr || !IsBeaconNetDriverConfigured()){
+		return nullptr;
+	}
+
+	AOnlineBeaconHost* BeaconHost = World->SpawnActor<AOnlineBeaconHost>(AOnlineBeaconHost::StaticClass());
+	if(BeaconHost == nullptr){
+		return nullptr;
+	}
+
+	BeaconHost->ListenPort = GetBeaconPort();
+	if(!BeaconHost->InitHost()){
+		UE_LOG(LogMenuSystem, Warning, TEXT("Reservation beacon can't listen on port %d, players join without a reservation"), BeaconHost->ListenPort);
+		BeaconHost->DestroyBeacon();
+		return nullptr;
+	}
+
+	OutHostObject = World->SpawnActor<AMenuSystemReservationBeaconHostObject>(AMenuSystemReservationBeaconHostObject::StaticClass());
+	if(OutHostObject == nullptr){
+		BeaconHost->DestroyBeacon();
+		return nullptr;
+	}
+
+	BeaconHost->RegisterHost(OutHostObject);
+	BeaconHost->PauseBeaconRequests(false);
+	UE_LOG(LogMenuSystem, Log, TEXT("Reservation beacon listening on port %d"), BeaconHost->GetListenPort());
+	return BeaconHost;
+}
+
+EMenuSystemReservationResult AMenuSystemReservationBeaconHostObject::ProcessReservationRequest(const FUniqueNetIdRepl& PlayerId, int32& OutOccupancy, int32& OutCapacity)
+{
+	AGameModeBase* GameMode = GetWorld()->GetAuthGameMode();
+	if(GameMode == nullptr || GameMode->GameSession == nullptr){
+		return EMenuSystemReservationResult::NotHosting;
+	}
+
+	//the reservation is matched to the player by the id they log in with, without one it would only hold a slot until it expires
+	if(!PlayerId.IsValid()){
+		return EMenuSystemReservationResult::InvalidPlayerId;
+	}
+
+	RemoveExpiredReservations();
+
+	//a player asking again (e.g. after their join failed) keeps their slot
+	const FString ReservationKey = PlayerId->ToString();
+	const bool bAlreadyReserved = Reservations.Contains(ReservationKey);
+
+	OutCapacity = GameMode->GameSession->MaxPlayers;
+	OutOccupancy = GameMode->GetNumPlayers() + Reservations.Num();
+	if(!bAlreadyReserved && OutOccupancy >= OutCapacity){
+		return EMenuSystemReservationResult::SessionFull;
+	}
+
+	Reservations.Add(ReservationKey, FPlatformTime::Seconds() + ReservationLifetimeSeconds);
+	OutOccupancy += bAlreadyReserved ? 0 : 1;
+	return EMenuSystemReservationResult::Accepted;
+}
+
+bool AMenuSystemReservationBeaconHostObject::HasSlotFor(const FUniqueNetIdRepl& PlayerId)
+{
+	AGameModeBase* GameMode = GetWorld()->GetAuthGameMode();
+	if(GameMode == nullptr || GameMode->GameSession == nullptr){
+		return true;
+	}
+
+	RemoveExpiredReservations();
+
+	//their slot is already counted in the reservations
+	if(PlayerId.IsValid() && Reservations.Contains(PlayerId->ToString())){
+		return true;
+	}
+	return GameMode->GetNumPlayers() + Reservations.Num() < GameMode->GameSession->MaxPlayers;
+}
+
+void AMenuSystemReservationBeaconHostObject::OnPlayerArrived(const FUniqueNetIdRepl& PlayerId)
+{
+	if(PlayerId.IsValid()){
+		Reservations.Remove(PlayerId->ToString());
+	}
+}
+
+void AMenuSystemReservationBeaconHostObject::RemoveExpiredReservations()
+{
+	const double Now = FPlatformTime::Seconds();
+	for(auto It = Reservations.CreateIterator(); It; ++It)
+	{
+		if(It.Value() <= Now){
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineBeaconClient.h"
+#include "OnlineBeaconHostObject.h"
+#include "GameFramework/OnlineReplStructs.h"
+#include "MenuSystemReservationBeacon.generated.h"
+
+class AOnlineBeaconHost;
+
+/** Answer of a host to a reservation request. */
+UENUM()
+enum class EMenuSystemReservationResult : uint8
+{
+	Accepted,			// a slot is held for the player until they arrive or the reservation expires
+	SessionFull,		// every slot is taken by a player or another reservation
+	NotHosting,			// the host has no game to join (any more)
+	InvalidPlayerId,	// the request carried no unique id, so the host could never tell when the player arrives
+	ConnectionFailed	// set on the client when the beacon could not reach the host or did not get an answer in time
+};
+
+/** Result, occupancy (players plus reservations, including ours if accepted) and capacity of the host. */
+DECLARE_DELEGATE_ThreeParams(FMenuSystemOnReservationResponse, EMenuSystemReservationResult /*Result*/, int32 /*Occupancy*/, int32 /*Capacity*/);
+
+/**
+ * Client side of the reservation handshake. It connects to the beacon port of a session found by a search and asks for a slot,
+ * which costs one small round trip instead of a full connection and map load to a host that turns out to be full or gone.
+ */
+UCLASS(Transient, NotPlaceable)
+class AMenuSystemReservationBeaconClient : public AOnlineBeaconClient
+{
+	GENERATED_BODY()
+
+public:
+	// AOnlineBeaconClient interface
+	virtual void OnConnected() override;
+	virtual void OnFailure() override;
+	// End of AOnlineBeaconClient interface
+
+	/** Connects to the beacon at ConnectInfo (host:port) and asks for a slot for PlayerId. Returns false if the connection could not be started */
+	bool RequestReservation(const FString& ConnectInfo, const FUniqueNetIdRepl& PlayerId);
+
+	/** Fired once with the answer of the host, or ConnectionFailed */
+	FMenuSystemOnReservationResponse OnReservationResponse;
+
+	UFUNCTION(Server, Reliable)
+	void ServerRequestReservation(const FUniqueNetIdRepl& PlayerId);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReservationResponse(EMenuSystemReservationResult Result, int32 Occupancy, int32 Capacity);
+
+private:
+	/** Fires OnReservationResponse unless it already fired */
+	void BroadcastResponse(EMenuSystemReservationResult Result, int32 Occupancy, int32 Capacity);
+
+	FUniqueNetIdRepl PendingPlayerId;
+	bool bResponded = false;
+};
+
+/**
+ * Host side of the reservation handshake, registered on the lobby's beacon host by AMenuSystemGameMode. Capacity is the
+ * game session's MaxPlayers (the session's NumPublicConnections), occupancy the players in the game plus the reservations
+ * of players that have not arrived yet. Reservations are by unique id, the id the player logs in with later, and the game
+ * mode turns away players without one once the free slots are all reserved.
+ */
+UCLASS(Transient, NotPlaceable, config=Game)
+class AMenuSystemReservationBeaconHostObject : public AOnlineBeaconHostObject
+{
+	GENERATED_BODY()
+
+public:
+	AMenuSystemReservationBeaconHostObject();
+
+	/** Answers a reservation request, holding a slot for the player if there is one */
+	EMenuSystemReservationResult ProcessReservationRequest(const FUniqueNetIdRepl& PlayerId, int32& OutOccupancy, int32& OutCapacity);
+
+	/** Returns true if a player logging in may take a slot: they hold a reservation, or a slot is left that nobody reserved. Checked by AMenuSystemGameMode::PreLogin */
+	bool HasSlotFor(const FUniqueNetIdRepl& PlayerId);
+
+	/** Releases the reservation of a player that arrived, their slot is now taken by the player itself */
+	void OnPlayerArrived(const FUniqueNetIdRepl& PlayerId);
+
+	/** Returns the port the beacon host tries first: -BeaconPort= or the beacon host config. If it is taken the net driver binds the next free one */
+	static int32 GetBeaconPort();
+
+	/** Returns true if the engine config defines the BeaconNetDriver the beacons need */
+	static bool IsBeaconNetDriverConfigured();
+
+	/** Spawns a beacon host listening on GetBeaconPort() (or the next free port) with this host object registered. Returns nullptr if it can't listen */
+	static AOnlineBeaconHost* StartHost(UWorld* World, AMenuSystemReservationBeaconHostObject*& OutHostObject);
+
+	/** Seconds a slot is held for a player that doesn't arrive */
+	UPROPERTY(Config)
+	float ReservationLifetimeSeconds = 30.f;
+
+private:
+	/** Drops the reservations of players that never arrived */
+	void RemoveExpiredReservations();
+
+	// FPlatformTime::Seconds() at which each reservation expires, by player id.
+	TMap<FString, double> Reservations;
+};
@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "GameFramework/OnlineReplStructs.h"
+
+/**
+ * The part of the online session interface our session code uses. It has two implementations:
+ * FMenuSystemOnlineSessionBackend forwards to the configured online subsystem (Steam, Null, ...), and
+ * FMenuSystemLoopbackSessionBackend keeps the sessions in memory so host/find/join can run without a backend or a network.
+ *
+ * The completion delegates and their Add/Clear/Trigger functions are the same as on IOnlineSession,
+ * so code written against one reads the same against the other.
+ */
+class IMenuSystemSessionBackend
+{
+public:
+	virtual ~IMenuSystemSessionBackend() {}
+
+	/** Name shown in logs and benchmark reports, e.g. the online subsystem name or "Loopback" */
+	virtual FName GetBackendName() const = 0;
+
+	/** Returns true if a session with this name exists locally (hosted or joined) */
+	virtual bool HasNamedSession(FName SessionName) const = 0;
+
+	// The PlayerId arguments may be invalid when there is no local player (headless runs), the backend then acts for local user 0.
+	virtual bool CreateSession(const FUniqueNetIdRepl& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) = 0;
+	virtual bool DestroySession(FName SessionName) = 0;
+	virtual bool FindSessions(const FUniqueNetIdRepl& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) = 0;
+	virtual bool CancelFindSessions() = 0;
+	virtual bool JoinSession(const FUniqueNetIdRepl& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) = 0;
+
+	/** Returns the settings of a session that exists locally, or nullptr */
+	virtual FOnlineSessionSettings* GetSessionSettings(FName SessionName) = 0;
+
+	/** Changes the advertised settings of a hosted session, searches see the new values once the backend has them */
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings) = 0;
+
+	/** Returns the address to travel to for a joined session, only valid once OnJoinSessionComplete succeeded */
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo) = 0;
+
+	/** Returns the address of a found session without joining it. PortType NAME_BeaconPort gives the address of its beacon (SETTING_BEACONPORT) */
+	virtual bool GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo) = 0;
+
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnCreateSessionComplete, FName, bool);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnDestroySessionComplete, FName, bool);
+	DEFINE_ONLINE_DELEGATE_ONE_PARAM(OnFindSessionsComplete, bool);
+	DEFINE_ONLINE_DELEGATE_TWO_PARAM(OnJoinSessionComplete, FName, EOnJoinSessionCompleteResult::Type);
+};
+
+/** Tuning of the loopback backend. Everything is driven by RandomSeed, so two runs with the same settings behave the same. */
+struct FMenuSystemLoopbackSettings
+{
+	/** Time every operation takes to complete, plus a random 0..LatencyJitterMs */
+	float LatencyMs = 50.f;
+	float LatencyJitterMs = 0.f;
+
+	/** Chance (0..1) that an operation fails, to exercise the retry and fallback paths */
+	float FailureRate = 0.f;
+
+	/** Number of made up sessions every search returns next to the ones hosted in this process */
+	int32 SyntheticSessionCount = 0;
+
+	/** Address returned by GetResolvedConnectString for every session */
+	FString ConnectAddress = TEXT("127.0.0.1:7777");
+
+	int32 RandomSeed = 0;
+};
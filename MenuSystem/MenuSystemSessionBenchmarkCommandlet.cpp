@@ -0,0 +1,502 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemSessionBenchmarkCommandlet.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "MenuSystemLoopbackSessionBackend.h"
+#include "MenuSystemSessionQuery.h"
+#include "MenuSystemSessionStats.h"
+#include "MenuSystemSessionSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMenuSystemSessionBenchmark, Log, All);
+
+namespace MenuSystemSessionBenchmark
+{
+	enum class EPhase : uint8
+	{
+		Host,
+		Find,		// JoinGameSession until the last page of the search that led to the join
+		Join,		// from there until the session is joined and its address resolved
+		Leave,
+		Destroy,
+		Num
+	};
+
+	static const TCHAR* PhaseNames[] = { TEXT("Host"), TEXT("Find"), TEXT("Join"), TEXT("Leave"), TEXT("Destroy") };
+	static_assert(UE_ARRAY_COUNT(PhaseNames) == (int32)EPhase::Num, "Missing phase name");
+
+	struct FPhaseTimings
+	{
+		TArray<double> SamplesMs;
+		int32 NumFailures = 0;
+	};
+
+	/** Nearest-rank percentile of an ascending sorted array */
+	static double Percentile(const TArray<double>& SortedSamples, double Percent)
+	{
+		if(SortedSamples.Num() == 0){
+			return 0.0;
+		}
+		const int32 Rank = FMath::CeilToInt(Percent / 100.0 * SortedSamples.Num());
+		return SortedSamples[FMath::Clamp(Rank - 1, 0, SortedSamples.Num() - 1)];
+	}
+
+	/** Memory in use by the process, and the total LLM tracks when it runs (-LLM) */
+	struct FMemorySnapshot
+	{
+		uint64 UsedPhysical = 0;
+		uint64 PeakUsedPhysical = 0;
+		uint64 LlmTracked = 0;
+
+		static FMemorySnapshot Take()
+		{
+			FMemorySnapshot Snapshot;
+			const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+			Snapshot.UsedPhysical = MemoryStats.UsedPhysical;
+			Snapshot.PeakUsedPhysical = MemoryStats.PeakUsedPhysical;
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+			if(FLowLevelMemTracker::IsEnabled()){
+				Snapshot.LlmTracked = FLowLevelMemTracker::Get().GetTotalTrackedMemory(ELLMTracker::Default);
+			}
+#endif
+			return Snapshot;
+		}
+	};
+
+	/** Bytes LLM attributes to the session code (the MenuSystemSession tag), or INDEX_NONE when LLM is off (-LLM turns it on) */
+	static int64 GetSessionTrackedBytes()
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		if(FLowLevelMemTracker::IsEnabled()){
+			//the tag amounts are collated once per frame, and we are in the middle of one
+			FLowLevelMemTracker::Get().UpdateStatsPerFrame();
+			return FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, FName(TEXT("MenuSystemSession")));
+		}
+#endif
+		return INDEX_NONE;
+	}
+
+	/** Creates a game instance without a world or a local player, its subsystems are initialized like the game's */
+	static UGameInstance* CreateHeadlessGameInstance()
+	{
+		UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+		//nothing else references it, and the waits tick the engine
+		GameInstance->AddToRoot();
+		GameInstance->Init();
+		return GameInstance;
+	}
+
+	static void DestroyHeadlessGameInstance(UGameInstance* GameInstance)
+	{
+		if(GameInstance){
+			GameInstance->Shutdown();
+			GameInstance->RemoveFromRoot();
+		}
+	}
+
+	/**
+	 * Drives the session subsystems of a host and a client through the session flows. All the waiting is done by ticking the core ticker
+	 * (which completes the loopback operations and ticks the online subsystems) until the completion delegate of the subsystem fired.
+	 */
+	class FRunner
+	{
+	public:
+		FRunner(UMenuSystemSessionSubsystem* InHost, UMenuSystemSessionSubsystem& InClient, double InTimeoutSeconds, bool bInColdSearch):
+			Host(InHost),
+			Client(InClient),
+			TimeoutSeconds(InTimeoutSeconds),
+			bColdSearch(bInColdSearch)
+		{
+		}
+
+		void RunIteration()
+		{
+			if(Host){
+				DestroyLeftoverSession(*Host);
+			}
+			DestroyLeftoverSession(Client);
+
+			if(Host && !HostSession()){
+				//nothing to find or to clean up
+				return;
+			}
+
+			if(bColdSearch){
+				Client.ClearSearchCache();
+			}
+			if(JoinSession()){
+				DestroySession(Client, EPhase::Leave);
+			}
+
+			if(Host){
+				DestroySession(*Host, EPhase::Destroy);
+			}
+		}
+
+		const FPhaseTimings& GetTimings(EPhase Phase) const { return Timings[(int32)Phase]; }
+		const TArray<double>& GetBytesPerSearch() const { return BytesPerSearch; }
+
+	private:
+		bool HostSession()
+		{
+			bool bCompleted = false;
+			bool bSucceeded = false;
+			const FDelegateHandle Handle = Host->OnCreateGameSessionComplete.AddLambda([&](bool bWasSuccessful){
+				bCompleted = true;
+				bSucceeded = bWasSuccessful;
+			});
+
+			const double StartTime = FPlatformTime::Seconds();
+			Host->CreateGameSession();
+			WaitFor(bCompleted);
+			if(!bCompleted){
+				Host->CancelSessionRequests();
+			}
+			Host->OnCreateGameSessionComplete.Remove(Handle);
+			return Record(EPhase::Host, StartTime, FPlatformTime::Seconds(), bSucceeded);
+		}
+
+		bool JoinSession()
+		{
+			bool bCompleted = false;
+			bool bSucceeded = false;
+			const FDelegateHandle Handle = Client.OnJoinGameSessionComplete.AddLambda([&](bool bWasSuccessful){
+				bCompleted = true;
+				bSucceeded = bWasSuccessful;
+			});
+
+			//the join of a candidate starts from the page that found it, just before that page is broadcast. A search started again
+			//because the cached candidates were gone ends with a later final page, the search is only over once that one arrived
+			double SearchEndTime = 0.0;
+			bool bFoundSessions = false;
+			const int64 TrackedBytesBefore = GetSessionTrackedBytes();
+			int64 SearchTrackedBytes = 0;
+			const FDelegateHandle PageHandle = Client.OnSessionSearchPage.AddLambda([&](TArrayView<const FOnlineSessionSearchResult> NewResults, bool bFinalPage){
+				if(bFinalPage){
+					SearchEndTime = FPlatformTime::Seconds();
+					bFoundSessions = Client.GetSearchResults().Num() > 0;
+					SearchTrackedBytes = GetSessionTrackedBytes() - TrackedBytesBefore;
+				}
+			});
+
+			const double StartTime = FPlatformTime::Seconds();
+			Client.JoinGameSession();
+			WaitFor(bCompleted);
+			const double EndTime = FPlatformTime::Seconds();
+			if(!bCompleted){
+				//a search, reservation or join still in flight would make every later join refuse to start
+				Client.CancelSessionRequests();
+			}
+			Client.OnSessionSearchPage.Remove(PageHandle);
+			Client.OnJoinGameSessionComplete.Remove(Handle);
+
+			const bool bSearchEnded = SearchEndTime > 0.0;
+			if(!Record(EPhase::Find, StartTime, bSearchEnded ? SearchEndTime : EndTime, bSearchEnded && bFoundSessions)){
+				return false;
+			}
+			if(TrackedBytesBefore != INDEX_NONE){
+				BytesPerSearch.Add((double)SearchTrackedBytes);
+			}
+			return Record(EPhase::Join, SearchEndTime, EndTime, bSucceeded);
+		}
+
+		bool DestroySession(UMenuSystemSessionSubsystem& SessionSubsystem, EPhase Phase)
+		{
+			bool bCompleted = false;
+			bool bSucceeded = false;
+			const FDelegateHandle Handle = SessionSubsystem.OnDestroyGameSessionComplete.AddLambda([&](bool bWasSuccessful){
+				bCompleted = true;
+				bSucceeded = bWasSuccessful;
+			});
+
+			const double StartTime = FPlatformTime::Seconds();
+			if(SessionSubsystem.DestroyGameSession()){
+				WaitFor(bCompleted);
+				if(!bCompleted){
+					SessionSubsystem.CancelSessionRequests();
+				}
+			}
+			SessionSubsystem.OnDestroyGameSessionComplete.Remove(Handle);
+			return Record(Phase, StartTime, FPlatformTime::Seconds(), bSucceeded);
+		}
+
+		/** Leaves the session a request that completed after its timeout left us in, outside of the timings */
+		void DestroyLeftoverSession(UMenuSystemSessionSubsystem& SessionSubsystem)
+		{
+			if(!SessionSubsystem.HasGameSession()){
+				return;
+			}
+
+			bool bCompleted = false;
+			const FDelegateHandle Handle = SessionSubsystem.OnDestroyGameSessionComplete.AddLambda([&](bool bWasSuccessful){
+				bCompleted = true;
+			});
+			if(SessionSubsystem.DestroyGameSession()){
+				WaitFor(bCompleted);
+				if(!bCompleted){
+					SessionSubsystem.CancelSessionRequests();
+				}
+			}
+			SessionSubsystem.OnDestroyGameSessionComplete.Remove(Handle);
+		}
+
+		/** Ticks until bCompleted is set by a delegate or the timeout is reached */
+		void WaitFor(const bool& bCompleted) const
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			double LastTickTime = StartTime;
+			while(!bCompleted && FPlatformTime::Seconds() - StartTime < TimeoutSeconds){
+				const double Now = FPlatformTime::Seconds();
+				FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+				FTSTicker::GetCoreTicker().Tick(Now - LastTickTime);
+				LastTickTime = Now;
+				if(!bCompleted){
+					FPlatformProcess::Sleep(0.f);
+				}
+			}
+		}
+
+		/** Adds the time from StartTime to EndTime to the phase (only successful runs are timed) and passes bSucceeded through */
+		bool Record(EPhase Phase, double StartTime, double EndTime, bool bSucceeded)
+		{
+			FPhaseTimings& PhaseTimings = Timings[(int32)Phase];
+			if(bSucceeded){
+				PhaseTimings.SamplesMs.Add((EndTime - StartTime) * 1000.0);
+			}
+			else{
+				PhaseTimings.NumFailures++;
+			}
+			return bSucceeded;
+		}
+
+		UMenuSystemSessionSubsystem* Host;
+		UMenuSystemSessionSubsystem& Client;
+		double TimeoutSeconds;
+		bool bColdSearch;
+
+		FPhaseTimings Timings[(int32)EPhase::Num];
+
+		// Change of the memory LLM attributes to the session code over each Find phase, only with -LLM.
+		TArray<double> BytesPerSearch;
+	};
+
+	static TSharedRef<FJsonObject> MakeStatsJson(TArray<double> Samples)
+	{
+		Samples.Sort();
+
+		double Sum = 0.0;
+		for(double Sample : Samples){
+			Sum += Sample;
+		}
+
+		TSharedRef<FJsonObject> StatsJson = MakeShared<FJsonObject>();
+		StatsJson->SetNumberField(TEXT("Count"), Samples.Num());
+		StatsJson->SetNumberField(TEXT("P50"), Percentile(Samples, 50.0));
+		StatsJson->SetNumberField(TEXT("P95"), Percentile(Samples, 95.0));
+		StatsJson->SetNumberField(TEXT("P99"), Percentile(Samples, 99.0));
+		StatsJson->SetNumberField(TEXT("Mean"), Samples.Num() > 0 ? Sum / Samples.Num() : 0.0);
+		StatsJson->SetNumberField(TEXT("Max"), Samples.Num() > 0 ? Samples.Last() : 0.0);
+		return StatsJson;
+	}
+
+	static double ToMB(uint64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UMenuSystemSessionBenchmarkCommandlet
+
+UMenuSystemSessionBenchmarkCommandlet::UMenuSystemSessionBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UMenuSystemSessionBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace MenuSystemSessionBenchmark;
+
+	if(GEngine == nullptr){
+		UE_LOG(LogMenuSystemSessionBenchmark, Error, TEXT("The session benchmark needs an engine to create its game instances"));
+		return 1;
+	}
+
+	int32 Iterations = 200;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	double TimeoutSeconds = 10.0;
+	FParse::Value(*Params, TEXT("Timeout="), TimeoutSeconds);
+	FString BackendName = FMenuSystemLoopbackSessionBackend::BackendName.ToString();
+	FParse::Value(*Params, TEXT("Backend="), BackendName);
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("SessionBenchmark.json");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	const bool bColdSearch = FParse::Param(*Params, TEXT("ColdSearch"));
+
+	//the game instances create their session subsystem from these defaults
+	UMenuSystemSessionSubsystem* SessionDefaults = GetMutableDefault<UMenuSystemSessionSubsystem>();
+	SessionDefaults->SessionBackendName = BackendName;
+	//there is no lobby to travel to, streaming its assets would only add to the timings and the memory
+	SessionDefaults->bPreloadLobbyAssets = false;
+
+	const bool bLoopback = BackendName == FMenuSystemLoopbackSessionBackend::BackendName.ToString();
+	if(bLoopback){
+		FParse::Value(*Params, TEXT("LatencyMs="), SessionDefaults->LoopbackLatencyMs);
+		FParse::Value(*Params, TEXT("JitterMs="), SessionDefaults->LoopbackLatencyJitterMs);
+		FParse::Value(*Params, TEXT("FailureRate="), SessionDefaults->LoopbackFailureRate);
+		FParse::Value(*Params, TEXT("SyntheticSessions="), SessionDefaults->LoopbackSyntheticSessionCount);
+		FParse::Value(*Params, TEXT("Seed="), SessionDefaults->LoopbackRandomSeed);
+	}
+	const FMenuSystemLoopbackSettings LoopbackSettings = SessionDefaults->MakeLoopbackSettings();
+
+	//two loopback backends share the hosted sessions of the process, like a listen server and a client would. An online subsystem
+	//has a single session interface, where host and client would both use NAME_GameSession: only the client runs against it
+	UGameInstance* HostInstance = bLoopback ? CreateHeadlessGameInstance() : nullptr;
+	SessionDefaults->LoopbackRandomSeed++;
+	UGameInstance* ClientInstance = CreateHeadlessGameInstance();
+
+	UMenuSystemSessionSubsystem* HostSubsystem = HostInstance ? HostInstance->GetSubsystem<UMenuSystemSessionSubsystem>() : nullptr;
+	UMenuSystemSessionSubsystem* ClientSubsystem = ClientInstance->GetSubsystem<UMenuSystemSessionSubsystem>();
+	if(ClientSubsystem == nullptr || !ClientSubsystem->SessionBackend.IsValid() || (bLoopback && (HostSubsystem == nullptr || !HostSubsystem->SessionBackend.IsValid()))){
+		UE_LOG(LogMenuSystemSessionBenchmark, Error, TEXT("No session backend named %s"), *BackendName);
+		DestroyHeadlessGameInstance(ClientInstance);
+		DestroyHeadlessGameInstance(HostInstance);
+		return 1;
+	}
+
+	const FString ReportedBackendName = ClientSubsystem->SessionBackend->GetBackendName().ToString();
+	UE_LOG(LogMenuSystemSessionBenchmark, Display, TEXT("Running %d iterations against %s%s"), Iterations, *ReportedBackendName, HostSubsystem ? TEXT("") : TEXT(" (client only)"));
+
+	FMenuSystemSessionCounters::Reset();
+	const FMemorySnapshot MemoryBefore = FMemorySnapshot::Take();
+
+	FRunner Runner(HostSubsystem, *ClientSubsystem, TimeoutSeconds, bColdSearch);
+	const double StartTime = FPlatformTime::Seconds();
+	for(int32 Iteration = 0; Iteration < Iterations; Iteration++){
+		Runner.RunIteration();
+	}
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const FMemorySnapshot MemoryAfter = FMemorySnapshot::Take();
+
+	DestroyHeadlessGameInstance(ClientInstance);
+	DestroyHeadlessGameInstance(HostInstance);
+
+	//report
+	TSharedRef<FJsonObject> ReportJson = MakeShared<FJsonObject>();
+	ReportJson->SetStringField(TEXT("Backend"), ReportedBackendName);
+	ReportJson->SetBoolField(TEXT("Host"), HostSubsystem != nullptr);
+	ReportJson->SetBoolField(TEXT("ColdSearch"), bColdSearch);
+	ReportJson->SetStringField(TEXT("BuildVersion"), FString::FromInt(FMenuSystemSessionQuery().WithLocalBuildVersion().BuildVersion));
+	ReportJson->SetNumberField(TEXT("Iterations"), Iterations);
+	ReportJson->SetNumberField(TEXT("TotalSeconds"), TotalSeconds);
+	if(bLoopback){
+		TSharedRef<FJsonObject> LoopbackJson = MakeShared<FJsonObject>();
+		LoopbackJson->SetNumberField(TEXT("LatencyMs"), LoopbackSettings.LatencyMs);
+		LoopbackJson->SetNumberField(TEXT("LatencyJitterMs"), LoopbackSettings.LatencyJitterMs);
+		LoopbackJson->SetNumberField(TEXT("FailureRate"), LoopbackSettings.FailureRate);
+		LoopbackJson->SetNumberField(TEXT("SyntheticSessionCount"), LoopbackSettings.SyntheticSessionCount);
+		LoopbackJson->SetNumberField(TEXT("RandomSeed"), LoopbackSettings.RandomSeed);
+		ReportJson->SetObjectField(TEXT("Loopback"), LoopbackJson);
+	}
+
+	TSharedRef<FJsonObject> PhasesJson = MakeShared<FJsonObject>();
+	for(int32 PhaseIndex = 0; PhaseIndex < (int32)EPhase::Num; PhaseIndex++){
+		const FPhaseTimings& PhaseTimings = Runner.GetTimings((EPhase)PhaseIndex);
+		TSharedRef<FJsonObject> PhaseJson = MakeStatsJson(PhaseTimings.SamplesMs);
+		PhaseJson->SetNumberField(TEXT("Failures"), PhaseTimings.NumFailures);
+		PhasesJson->SetObjectField(PhaseNames[PhaseIndex], PhaseJson);
+
+		UE_LOG(LogMenuSystemSessionBenchmark, Display, TEXT("%-8s p50 %8.3f ms  p95 %8.3f ms  p99 %8.3f ms  max %8.3f ms  (%d ok, %d failed)"),
+			PhaseNames[PhaseIndex],
+			PhaseJson->GetNumberField(TEXT("P50")),
+			PhaseJson->GetNumberField(TEXT("P95")),
+			PhaseJson->GetNumberField(TEXT("P99")),
+			PhaseJson->GetNumberField(TEXT("Max")),
+			PhaseTimings.SamplesMs.Num(),
+			PhaseTimings.NumFailures
+		);
+	}
+	ReportJson->SetObjectField(TEXT("PhasesMs"), PhasesJson);
+
+	//the individual backend operations the phases are made of, as the subsystem counted them (a join phase may search several pages and try several candidates)
+	TSharedRef<FJsonObject> OperationsJson = MakeShared<FJsonObject>();
+	for(int32 OpIndex = 0; OpIndex < (int32)EMenuSystemSessionOp::Num; OpIndex++){
+		const FMenuSystemSessionOpTotals Totals = FMenuSystemSessionCounters::GetTotals((EMenuSystemSessionOp)OpIndex);
+		const int32 NumCompleted = Totals.NumSucceeded + Totals.NumFailed;
+
+		TSharedRef<FJsonObject> OpJson = MakeShared<FJsonObject>();
+		OpJson->SetNumberField(TEXT("Started"), Totals.NumStarted);
+		OpJson->SetNumberField(TEXT("Succeeded"), Totals.NumSucceeded);
+		OpJson->SetNumberField(TEXT("Failed"), Totals.NumFailed);
+		OpJson->SetNumberField(TEXT("MeanMs"), NumCompleted > 0 ? Totals.TotalSeconds * 1000.0 / NumCompleted : 0.0);
+		OpJson->SetNumberField(TEXT("MaxMs"), Totals.MaxSeconds * 1000.0);
+		OperationsJson->SetObjectField(FMenuSystemSessionCounters::GetOpName((EMenuSystemSessionOp)OpIndex), OpJson);
+	}
+	ReportJson->SetObjectField(TEXT("Operations"), OperationsJson);
+	FMenuSystemSessionCounters::Dump(*GLog);
+
+	//a count of the allocations would need a hook in GMalloc, the memory the session code holds after each search is what LLM can tell us
+	TSharedRef<FJsonObject> SearchMemoryJson = MakeStatsJson(Runner.GetBytesPerSearch());
+	SearchMemoryJson->SetStringField(TEXT("Source"), Runner.GetBytesPerSearch().Num() > 0 ? TEXT("LLM MenuSystemSession tag, bytes") : TEXT("Not measured, run with -LLM"));
+	ReportJson->SetObjectField(TEXT("AllocationsPerSearch"), SearchMemoryJson);
+	UE_LOG(LogMenuSystemSessionBenchmark, Display, TEXT("Session memory per search: p50 %.0f  p95 %.0f  max %.0f bytes%s"),
+		SearchMemoryJson->GetNumberField(TEXT("P50")),
+		SearchMemoryJson->GetNumberField(TEXT("P95")),
+		SearchMemoryJson->GetNumberField(TEXT("Max")),
+		Runner.GetBytesPerSearch().Num() > 0 ? TEXT("") : TEXT(" (not measured, run with -LLM)")
+	);
+
+	//what the report does not cover, so a missing number is not mistaken for a free one
+	TArray<TSharedPtr<FJsonValue>> NotMeasuredJson;
+	NotMeasuredJson.Add(MakeShared<FJsonValueString>(TEXT("ServerTravel and ClientTravel: the headless game instances have no world to travel from, the soak test reports their counters")));
+	NotMeasuredJson.Add(MakeShared<FJsonValueString>(TEXT("Reserve: headless hosts run no reservation beacon, the client joins them directly")));
+	ReportJson->SetArrayField(TEXT("NotMeasured"), NotMeasuredJson);
+
+	//growth per iteration is what points at a leak, the peak at what a single flow costs
+	TSharedRef<FJsonObject> MemoryJson = MakeShared<FJsonObject>();
+	MemoryJson->SetNumberField(TEXT("UsedPhysicalStartMB"), ToMB(MemoryBefore.UsedPhysical));
+	MemoryJson->SetNumberField(TEXT("UsedPhysicalEndMB"), ToMB(MemoryAfter.UsedPhysical));
+	MemoryJson->SetNumberField(TEXT("PeakUsedPhysicalMB"), ToMB(MemoryAfter.PeakUsedPhysical));
+	MemoryJson->SetNumberField(TEXT("UsedPhysicalGrowthPerIterationKB"), Iterations > 0 ? ((double)MemoryAfter.UsedPhysical - (double)MemoryBefore.UsedPhysical) / 1024.0 / Iterations : 0.0);
+	if(MemoryBefore.LlmTracked > 0){
+		MemoryJson->SetNumberField(TEXT("LlmTrackedStartMB"), ToMB(MemoryBefore.LlmTracked));
+		MemoryJson->SetNumberField(TEXT("LlmTrackedEndMB"), ToMB(MemoryAfter.LlmTracked));
+		MemoryJson->SetNumberField(TEXT("LlmTrackedGrowthPerIterationKB"), Iterations > 0 ? ((double)MemoryAfter.LlmTracked - (double)MemoryBefore.LlmTracked) / 1024.0 / Iterations : 0.0);
+	}
+	ReportJson->SetObjectField(TEXT("Memory"), MemoryJson);
+	UE_LOG(LogMenuSystemSessionBenchmark, Display, TEXT("Memory: %.1f MB -> %.1f MB (peak %.1f MB)%s"),
+		ToMB(MemoryBefore.UsedPhysical),
+		ToMB(MemoryAfter.UsedPhysical),
+		ToMB(MemoryAfter.PeakUsedPhysical),
+		MemoryBefore.LlmTracked > 0 ? *FString::Printf(TEXT(", LLM %.1f MB -> %.1f MB"), ToMB(MemoryBefore.LlmTracked), ToMB(MemoryAfter.LlmTracked)) : TEXT("")
+	);
+
+	FString ReportString;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&ReportString);
+	if(!FJsonSerializer::Serialize(ReportJson, JsonWriter) || !FFileHelper::SaveStringToFile(ReportString, *OutputPath)){
+		UE_LOG(LogMenuSystemSessionBenchmark, Error, TEXT("Could not write %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogMenuSystemSessionBenchmark, Display, TEXT("Wrote %s"), *OutputPath);
+
+	//any failure of a phase makes the run fail, so CI notices a broken flow and not only a slow one
+	for(int32 PhaseIndex = 0; PhaseIndex < (int32)EPhase::Num; PhaseIndex++){
+		if(Runner.GetTimings((EPhase)PhaseIndex).NumFailures > 0 && LoopbackSettings.FailureRate <= 0.f){
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,41 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MenuSystemSessionBenchmarkCommandlet.generated.h"
+
+/**
+ * Runs the host and join session flows many times without a world or a player and reports how long each phase took.
+ *
+ * UnrealEditor-Cmd MenuSystem -run=MenuSystemSessionBenchmark [-Iterations=200] [-Backend=Loopback|Null|...] [-ColdSearch]
+ *     [-LatencyMs=] [-JitterMs=] [-FailureRate=] [-SyntheticSessions=] [-Seed=] [-Timeout=10] [-Output=<path>.json]
+ *
+ * The flows go through UMenuSystemSessionSubsystem, the way the game runs them: a host game instance and a client game instance,
+ * both headless. Every iteration the host creates a session, the client joins the best session it finds (paging, the search cache,
+ * the candidate fallback and the address resolve included), leaves it, and the host ends its session. -ColdSearch clears the
+ * search cache before every join, so every join goes to the backend. The reservation step needs a world and the beacon net driver,
+ * it is covered by the soak test instead: headless hosts don't advertise a beacon, so the client joins directly.
+ *
+ * An online subsystem has one session interface per process, so with -Backend=<subsystem> only the client runs and joins the
+ * sessions hosted elsewhere. The loopback options default to the [MenuSystemSessionSubsystem] config.
+ *
+ * Per phase (Host, Find, Join, Leave, Destroy) we report p50/p95/p99, mean, max and failure counts, the FMenuSystemSessionCounters
+ * of every session operation, the memory in use before and after the run, and with -LLM the change of the session code's memory
+ * (the MenuSystemSession LLM tag) over each search, as JSON (Saved/Benchmarks by default) so two builds can be compared.
+ * Travel can't be timed without a world, the report lists what it doesn't measure. For the individual allocations of each
+ * operation, run with -trace=memory: the counters bookmark every completion.
+ */
+UCLASS()
+class UMenuSystemSessionBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMenuSystemSessionBenchmarkCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End of UCommandlet interface
+};
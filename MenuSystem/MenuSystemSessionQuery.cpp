@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemSessionQuery.h"
+#include "Misc/NetworkVersion.h"
+#include "OnlineSessionSettings.h"
+
+FMenuSystemSessionQuery& FMenuSystemSessionQuery::WithLocalBuildVersion()
+{
+	return WithBuildVersion(static_cast<int32>(FNetworkVersion::GetLocalNetworkVersion()));
+}
+
+void FMenuSystemSessionQuery::ApplyTo(FOnlineSessionSearch& SessionSearch) const
+{
+	//ViaOnlineService keys are sent along with the search, so the backend only returns the sessions that pass all of them
+	if(!MatchType.IsEmpty()){
+		SessionSearch.QuerySettings.Set(SETTING_MENUSYSTEM_MATCHTYPE, MatchType, EOnlineComparisonOp::Equals);
+	}
+	if(!Region.IsEmpty()){
+		SessionSearch.QuerySettings.Set(SETTING_MENUSYSTEM_REGION, Region, EOnlineComparisonOp::Equals);
+	}
+	if(BuildVersion != 0){
+		SessionSearch.QuerySettings.Set(SETTING_MENUSYSTEM_BUILDVERSION, BuildVersion, EOnlineComparisonOp::Equals);
+	}
+	if(MinOpenSlots > 0){
+		SessionSearch.QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, MinOpenSlots, EOnlineComparisonOp::GreaterThanEquals);
+	}
+}
+
+void FMenuSystemSessionQuery::AdvertiseIn(FOnlineSessionSettings& SessionSettings) const
+{
+	if(!MatchType.IsEmpty()){
+		SessionSettings.Set(SETTING_MENUSYSTEM_MATCHTYPE, MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	}
+	if(!Region.IsEmpty()){
+		SessionSettings.Set(SETTING_MENUSYSTEM_REGION, Region, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	}
+	if(BuildVersion != 0){
+		SessionSettings.Set(SETTING_MENUSYSTEM_BUILDVERSION, BuildVersion, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	}
+}
+
+bool FMenuSystemSessionQuery::Matches(const FOnlineSessionSearchResult& SearchResult) const
+{
+	const FOnlineSessionSettings& Settings = SearchResult.Session.SessionSettings;
+
+	if(!MatchType.IsEmpty()){
+		FString ResultMatchType;
+		if(!Settings.Get(SETTING_MENUSYSTEM_MATCHTYPE, ResultMatchType) || ResultMatchType != MatchType){
+			return false;
+		}
+	}
+	if(!Region.IsEmpty()){
+		FString ResultRegion;
+		if(!Settings.Get(SETTING_MENUSYSTEM_REGION, ResultRegion) || ResultRegion != Region){
+			return false;
+		}
+	}
+	if(BuildVersion != 0){
+		int32 ResultBuildVersion = 0;
+		if(!Settings.Get(SETTING_MENUSYSTEM_BUILDVERSION, ResultBuildVersion) || ResultBuildVersion != BuildVersion){
+			return false;
+		}
+	}
+	if(MinOpenSlots > 0 && SearchResult.Session.NumOpenPublicConnections < MinOpenSlots){
+		return false;
+	}
+	return true;
+}
+
+FString FMenuSystemSessionQuery::ToCacheKey() const
+{
+	//LAN and online searches see different sessions
+	return FString::Printf(TEXT("%s|%s|%d|%d|%s"), *MatchType, *Region, BuildVersion, MinOpenSlots, bLanQuery ? TEXT("LAN") : TEXT("Online"));
+}
@@ -0,0 +1,60 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSearch;
+class FOnlineSessionSearchResult;
+class FOnlineSessionSettings;
+
+// Keys we advertise in the session settings when hosting, and filter on when searching
+#define SETTING_MENUSYSTEM_MATCHTYPE FName(TEXT("MatchType"))
+#define SETTING_MENUSYSTEM_REGION FName(TEXT("Region"))
+#define SETTING_MENUSYSTEM_BUILDVERSION FName(TEXT("BuildVersion"))
+
+/**
+ * Typed description of the sessions we are looking for. It is turned into FOnlineSessionSearch::QuerySettings,
+ * so the filtering is done by the online backend instead of downloading every session and comparing on the client.
+ * Empty/zero fields mean "any".
+ *
+ *	FMenuSystemSessionQuery Query = FMenuSystemSessionQuery().WithMatchType(TEXT("FreeForAll")).WithMinOpenSlots(1);
+ */
+struct FMenuSystemSessionQuery
+{
+	/** Match type advertised under SETTING_MENUSYSTEM_MATCHTYPE, e.g. "FreeForAll" */
+	FString MatchType;
+
+	/** Region advertised under SETTING_MENUSYSTEM_REGION */
+	FString Region;
+
+	/** Network version of the host build, sessions of incompatible builds are filtered out. 0 accepts any build */
+	int32 BuildVersion = 0;
+
+	/** Minimum number of open public connections the session must have */
+	int32 MinOpenSlots = 0;
+
+	/** Discover sessions by broadcasting on the local network instead of asking the online service */
+	bool bLanQuery = false;
+
+	FMenuSystemSessionQuery& WithMatchType(const FString& InMatchType) { MatchType = InMatchType; return *this; }
+	FMenuSystemSessionQuery& WithRegion(const FString& InRegion) { Region = InRegion; return *this; }
+	FMenuSystemSessionQuery& WithBuildVersion(int32 InBuildVersion) { BuildVersion = InBuildVersion; return *this; }
+	FMenuSystemSessionQuery& WithMinOpenSlots(int32 InMinOpenSlots) { MinOpenSlots = InMinOpenSlots; return *this; }
+	FMenuSystemSessionQuery& WithLanQuery(bool bInLanQuery) { bLanQuery = bInLanQuery; return *this; }
+
+	/** Restricts the search to the build we are running (see FNetworkVersion) */
+	FMenuSystemSessionQuery& WithLocalBuildVersion();
+
+	/** Adds the filters of this query to the QuerySettings of the search */
+	void ApplyTo(FOnlineSessionSearch& SessionSearch) const;
+
+	/** Advertises the keys this query filters on, so a search with the same query finds the hosted session */
+	void AdvertiseIn(FOnlineSessionSettings& SessionSettings) const;
+
+	/** Checks a search result against the query on the client, for backends that ignore some of the filters */
+	bool Matches(const FOnlineSessionSearchResult& SearchResult) const;
+
+	/** Key identifying the query in the search cache, two queries with the same key find the same sessions */
+	FString ToCacheKey() const;
+};
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemSessionRanking.h"
+#include "MenuSystemSessionQuery.h"
+#include "OnlineSessionSettings.h"
+
+float FMenuSystemSessionRanking::Score(const FOnlineSessionSearchResult& SearchResult, const FMenuSystemSessionQuery& Query) const
+{
+	const int32 OpenSlots = SearchResult.Session.NumOpenPublicConnections;
+	if(OpenSlots <= 0 || !Query.Matches(SearchResult)){
+		return TNumericLimits<float>::Lowest();
+	}
+
+	const int32 PingInMs = SearchResult.PingInMs >= MAX_QUERY_PING ? UnknownPingMs : SearchResult.PingInMs;
+	float Score = -PingWeight * PingInMs;
+	Score += OpenSlotWeight * FMath::Min(OpenSlots, MaxScoredOpenSlots);
+
+	if(Query.MatchType.IsEmpty() && !PreferredMatchType.IsEmpty()){
+		FString MatchType;
+		if(SearchResult.Session.SessionSettings.Get(SETTING_MENUSYSTEM_MATCHTYPE, MatchType) && MatchType == PreferredMatchType){
+			Score += PreferredMatchTypeBonus;
+		}
+	}
+	return Score;
+}
+
+void FMenuSystemSessionRanking::Rank(const TArray<FOnlineSessionSearchResult>& SearchResults, const FMenuSystemSessionQuery& Query, TArray<int32>& OutCandidates) const
+{
+	OutCandidates.Reset();
+
+	TArray<float> Scores;
+	Scores.SetNumUninitialized(SearchResults.Num());
+
+	for(int32 Index = 0; Index < SearchResults.Num(); ++Index)
+	{
+		Scores[Index] = Score(SearchResults[Index], Query);
+		if(Scores[Index] > TNumericLimits<float>::Lowest()){
+			OutCandidates.Add(Index);
+		}
+	}
+
+	//stable, so sessions with the same score keep the order the backend returned them in
+	OutCandidates.StableSort([&Scores](int32 A, int32 B) { return Scores[A] > Scores[B]; });
+}
@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSearchResult;
+struct FMenuSystemSessionQuery;
+
+/**
+ * Scores session search results so we join the best one on the first try, instead of the first one we came across.
+ * Lower ping scores higher, a few open slots add to the score (a nearly full session is more likely to be full by the time we get there),
+ * and sessions with our preferred match type get a bonus. Sessions that don't match the query or have no open slot are never candidates.
+ */
+struct FMenuSystemSessionRanking
+{
+	/** Score lost per millisecond of ping */
+	float PingWeight = 1.f;
+
+	/** Ping assumed for sessions whose ping is unknown (the backend reports MAX_QUERY_PING for those) */
+	int32 UnknownPingMs = 250;
+
+	/** Score gained per open slot, up to MaxScoredOpenSlots */
+	float OpenSlotWeight = 10.f;
+	int32 MaxScoredOpenSlots = 4;
+
+	/** Match type preferred when the query accepts any, and the score it is worth */
+	FString PreferredMatchType;
+	float PreferredMatchTypeBonus = 100.f;
+
+	/** Returns the score of a search result, or TNumericLimits<float>::Lowest() if it can't be joined with this query */
+	float Score(const FOnlineSessionSearchResult& SearchResult, const FMenuSystemSessionQuery& Query) const;
+
+	/** Fills OutCandidates with the indices of the joinable results, best first. The results themselves are not copied */
+	void Rank(const TArray<FOnlineSessionSearchResult>& SearchResults, const FMenuSystemSessionQuery& Query, TArray<int32>& OutCandidates) const;
+};
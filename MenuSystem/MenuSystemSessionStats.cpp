@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemSessionStats.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+LLM_DEFINE_TAG(MenuSystemSession);
+
+#if MENUSYSTEM_SESSION_COUNTERS
+
+namespace MenuSystemSessionCounters
+{
+	static const TCHAR* OpNames[] = { TEXT("Create"), TEXT("Destroy"), TEXT("Find"), TEXT("Join"), TEXT("Reserve"), TEXT("ResolveConnectString"), TEXT("ServerTravel"), TEXT("ClientTravel") };
+	static_assert(UE_ARRAY_COUNT(OpNames) == (int32)EMenuSystemSessionOp::Num, "Missing operation name");
+
+	struct FOpCounter : public FMenuSystemSessionOpTotals
+	{
+		// FPlatformTime::Seconds() of the Begin in flight, 0 when there is none
+		double StartTime = 0.;
+	};
+
+	// Only touched from the game thread, where the session callbacks and the travel notifications run.
+	static FOpCounter Counters[(int32)EMenuSystemSessionOp::Num];
+
+	static FAutoConsoleCommandWithOutputDevice DumpStatsCommand(
+		TEXT("MenuSystem.Session.DumpStats"),
+		TEXT("Prints how often each session and travel operation ran and how long it took"),
+		FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FMenuSystemSessionCounters::Dump)
+	);
+
+	static FAutoConsoleCommand ResetStatsCommand(
+		TEXT("MenuSystem.Session.ResetStats"),
+		TEXT("Resets the counters printed by MenuSystem.Session.DumpStats"),
+		FConsoleCommandDelegate::CreateStatic(&FMenuSystemSessionCounters::Reset)
+	);
+}
+
+void FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp Op)
+{
+	check(IsInGameThread());
+	MenuSystemSessionCounters::FOpCounter& Counter = MenuSystemSessionCounters::Counters[(int32)Op];
+	Counter.NumStarted++;
+	Counter.StartTime = FPlatformTime::Seconds();
+}
+
+void FMenuSystemSessionCounters::End(EMenuSystemSessionOp Op, bool bSucceeded)
+{
+	check(IsInGameThread());
+	MenuSystemSessionCounters::FOpCounter& Counter = MenuSystemSessionCounters::Counters[(int32)Op];
+	if(Counter.StartTime <= 0.){
+		return;
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - Counter.StartTime;
+	Counter.StartTime = 0.;
+	Counter.TotalSeconds += Seconds;
+	Counter.MaxSeconds = FMath::Max(Counter.MaxSeconds, Seconds);
+	if(bSucceeded){
+		Counter.NumSucceeded++;
+	}
+	else{
+		Counter.NumFailed++;
+	}
+
+	//the operations span several frames, a bookmark marks where each one completed on the Insights timeline
+	TRACE_BOOKMARK(TEXT("MenuSystem %s %s (%.1f ms)"), MenuSystemSessionCounters::OpNames[(int32)Op], bSucceeded ? TEXT("succeeded") : TEXT("failed"), Seconds * 1000.);
+}
+
+FMenuSystemSessionOpTotals FMenuSystemSessionCounters::GetTotals(EMenuSystemSessionOp Op)
+{
+	check(IsInGameThread());
+	return MenuSystemSessionCounters::Counters[(int32)Op];
+}
+
+const TCHAR* FMenuSystemSessionCounters::GetOpName(EMenuSystemSessionOp Op)
+{
+	return MenuSystemSessionCounters::OpNames[(int32)Op];
+}
+
+void FMenuSystemSessionCounters::Dump(FOutputDevice& Ar)
+{
+	Ar.Logf(TEXT("%-20s %8s %8s %8s %10s %10s"), TEXT("Operation"), TEXT("Started"), TEXT("Ok"), TEXT("Failed"), TEXT("Avg ms"), TEXT("Max ms"));
+	for(int32 OpIndex = 0; OpIndex < (int32)EMenuSystemSessionOp::Num; OpIndex++){
+		const MenuSystemSessionCounters::FOpCounter& Counter = MenuSystemSessionCounters::Counters[OpIndex];
+		const int32 NumCompleted = Counter.NumSucceeded + Counter.NumFailed;
+		Ar.Logf(TEXT("%-20s %8d %8d %8d %10.2f %10.2f"),
+			MenuSystemSessionCounters::OpNames[OpIndex],
+			Counter.NumStarted,
+			Counter.NumSucceeded,
+			Counter.NumFailed,
+			NumCompleted > 0 ? Counter.TotalSeconds * 1000. / NumCompleted : 0.,
+			Counter.MaxSeconds * 1000.
+		);
+	}
+}
+
+void FMenuSystemSessionCounters::Reset()
+{
+	for(MenuSystemSessionCounters::FOpCounter& Counter : MenuSystemSessionCounters::Counters){
+		//keep the operations in flight, their End still belongs to the new totals
+		const double StartTime = Counter.StartTime;
+		Counter = MenuSystemSessionCounters::FOpCounter();
+		Counter.StartTime = StartTime;
+	}
+}
+
+#endif // MENUSYSTEM_SESSION_COUNTERS
@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// "stat MenuSystemSession" shows the game thread time of the session code (stats are compiled out in Test and Shipping).
+DECLARE_STATS_GROUP(TEXT("MenuSystemSession"), STATGROUP_MenuSystemSession, STATCAT_Advanced);
+
+// LLM tag of the memory allocated by the session code (run with -LLM), e.g. the search results and the cache.
+LLM_DECLARE_TAG(MenuSystemSession);
+
+// Wall clock counters of the session operations, compiled out of shipping builds.
+#ifndef MENUSYSTEM_SESSION_COUNTERS
+	#define MENUSYSTEM_SESSION_COUNTERS !UE_BUILD_SHIPPING
+#endif
+
+/** The session and travel operations we time from their request to their completion callback. */
+enum class EMenuSystemSessionOp : uint8
+{
+	Create,
+	Destroy,
+	Find,
+	Join,
+	Reserve,
+	ResolveConnectString,
+	ServerTravel,
+	ClientTravel,
+	Num
+};
+
+/** What the counters of one operation add up to. */
+struct FMenuSystemSessionOpTotals
+{
+	int32 NumStarted = 0;
+	int32 NumSucceeded = 0;
+	int32 NumFailed = 0;
+	double TotalSeconds = 0.;
+	double MaxSeconds = 0.;
+};
+
+/**
+ * Process wide counters of the session operations: how often each one was started, succeeded and failed,
+ * and how long it took from Begin to End. Stats only see the game thread time of our callbacks, these also
+ * cover the time spent waiting on the backend or the travel. Dump them with "MenuSystem.Session.DumpStats".
+ */
+struct FMenuSystemSessionCounters
+{
+#if MENUSYSTEM_SESSION_COUNTERS
+	/** Starts timing an operation. Only one operation of each kind is expected in flight, a second Begin restarts the timer */
+	static void Begin(EMenuSystemSessionOp Op);
+
+	/** Stops timing an operation. Ignored if the operation was not begun, e.g. a map load we did not ask for */
+	static void End(EMenuSystemSessionOp Op, bool bSucceeded);
+
+	/** Returns the counters of an operation, e.g. for a benchmark report */
+	static FMenuSystemSessionOpTotals GetTotals(EMenuSystemSessionOp Op);
+	static const TCHAR* GetOpName(EMenuSystemSessionOp Op);
+
+	static void Dump(FOutputDevice& Ar);
+	static void Reset();
+#else
+	static void Begin(EMenuSystemSessionOp Op) {}
+	static void End(EMenuSystemSessionOp Op, bool bSucceeded) {}
+	static FMenuSystemSessionOpTotals GetTotals(EMenuSystemSessionOp Op) { return FMenuSystemSessionOpTotals(); }
+	static const TCHAR* GetOpName(EMenuSystemSessionOp Op) { return TEXT(""); }
+	static void Dump(FOutputDevice& Ar) {}
+	static void Reset() {}
+#endif
+};
+
+// Stat, Insights and LLM scope of a session function. The trace scope stays in Test builds, where stats are compiled out.
+#define MENUSYSTEM_SESSION_SCOPE(StatId) \
+	SCOPE_CYCLE_COUNTER(StatId); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(StatId); \
+	LLM_SCOPE_BYTAG(MenuSystemSession)
@@ -0,0 +1,1118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemSessionSubsystem.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameMapsSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "MenuSystemGameMode.h"
+#include "MenuSystemLoopbackSessionBackend.h"
+#include "MenuSystemOnlineSessionBackend.h"
+#include "MenuSystemReservationBeacon.h"
+#include "MenuSystemSessionStats.h"
+#include "MenuSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Create Game Session"), STAT_MenuSystem_CreateGameSession, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("On Create Session Complete"), STAT_MenuSystem_OnCreateSessionComplete, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("On Destroy Session Complete"), STAT_MenuSystem_OnDestroySessionComplete, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("Start Session Search"), STAT_MenuSystem_StartSessionSearch, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("Start Search Page"), STAT_MenuSystem_StartSearchPage, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("On Find Sessions Complete"), STAT_MenuSystem_OnFindSessionsComplete, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("Update Search Cache"), STAT_MenuSystem_UpdateSearchCache, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("Rank Search Results"), STAT_MenuSystem_RankSearchResults, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("Join Session"), STAT_MenuSystem_JoinSession, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("On Join Session Complete"), STAT_MenuSystem_OnJoinSessionComplete, STATGROUP_MenuSystemSession);
+DECLARE_CYCLE_STAT(TEXT("Preload Lobby Assets"), STAT_MenuSystem_PreloadLobbyAssets, STATGROUP_MenuSystemSession);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Search Results Received"), STAT_MenuSystem_SearchResultsReceived, STATGROUP_MenuSystemSession);
+
+static TAutoConsoleVariable<int32> CVarMenuSystemDiscoveryMode(
+	TEXT("MenuSystem.Session.DiscoveryMode"),
+	-1,
+	TEXT("How sessions are advertised and discovered: -1 uses the config (or -LAN), 0 Online, 1 LAN, 2 Auto (LAN search first, then online; hosts advertise online). Read by the next host/search."),
+	ECVF_Default
+);
+
+//////////////////////////////////////////////////////////////////////////
+// UMenuSystemSessionSubsystem
+
+UMenuSystemSessionSubsystem::UMenuSystemSessionSubsystem():
+	//binding the delegates to their callback functions, they are added to the session backend delegate lists right before each operation
+	CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
+	DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
+	FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
+	JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete))
+{
+}
+
+void UMenuSystemSessionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SessionRanking.PreferredMatchType = HostMatchType;
+
+	//the subsystem lives as long as the game instance, so the session backend only needs to be created once (not on every pawn spawn)
+	SessionBackend = CreateSessionBackend();
+	if(SessionBackend.IsValid()){
+		UE_LOG(LogMenuSystem, Log, TEXT("Using session backend %s"), *SessionBackend->GetBackendName().ToString());
+	}
+	else{
+		UE_LOG(LogMenuSystem, Warning, TEXT("No session backend, hosting and joining are disabled"));
+	}
+
+	//travel has no completion callback of its own, it ends with the new map loaded or a travel/network failure
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+	if(GEngine){
+		TravelFailureHandle = GEngine->OnTravelFailure().AddUObject(this, &ThisClass::OnTravelFailure);
+		NetworkFailureHandle = GEngine->OnNetworkFailure().AddUObject(this, &ThisClass::OnNetworkFailure);
+	}
+}
+
+TSharedPtr<IMenuSystemSessionBackend> UMenuSystemSessionSubsystem::CreateSessionBackend() const
+{
+	//-SessionBackend=Loopback on the command line wins over the config, so CI and benchmark runs don't need their own ini
+	FString BackendName = SessionBackendName;
+	FParse::Value(FCommandLine::Get(), TEXT("SessionBackend="), BackendName);
+
+	if(BackendName == FMenuSystemLoopbackSessionBackend::BackendName.ToString()){
+		return MakeShared<FMenuSystemLoopbackSessionBackend>(MakeLoopbackSettings());
+	}
+
+	//anything else names an online subsystem, empty (the default) means the default one (Steam)
+	return FMenuSystemOnlineSessionBackend::Create(BackendName.IsEmpty() ? NAME_None : FName(*BackendName));
+}
+
+FMenuSystemLoopbackSettings UMenuSystemSessionSubsystem::MakeLoopbackSettings() const
+{
+	FMenuSystemLoopbackSettings LoopbackSettings;
+	LoopbackSettings.LatencyMs = LoopbackLatencyMs;
+	LoopbackSettings.LatencyJitterMs = LoopbackLatencyJitterMs;
+	LoopbackSettings.FailureRate = LoopbackFailureRate;
+	LoopbackSettings.SyntheticSessionCount = LoopbackSyntheticSessionCount;
+	LoopbackSettings.RandomSeed = LoopbackRandomSeed;
+	return LoopbackSettings;
+}
+
+void UMenuSystemSessionSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	if(GEngine){
+		GEngine->OnTravelFailure().Remove(TravelFailureHandle);
+		GEngine->OnNetworkFailure().Remove(NetworkFailureHandle);
+	}
+
+	ReleaseLobbyPreload();
+	FTSTicker::GetCoreTicker().RemoveTicker(LanSearchTimeoutHandle);
+	LanSearchTimeoutHandle.Reset();
+	EndReservation();
+	ClearSessionDelegates();
+	SessionBackend.Reset();
+	SessionSearch.Reset();
+	SearchResults.Empty();
+	SearchResultIndices.Empty();
+	BackendResultIds.Empty();
+	SearchCache.Empty();
+	JoinCandidates.Empty();
+	SearchPageIndex = INDEX_NONE;
+	PendingSessionSettings.Reset();
+	HostState = EMenuSystemHostState::Idle;
+
+	Super::Deinitialize();
+}
+
+FUniqueNetIdRepl UMenuSystemSessionSubsystem::GetSessionPlayerId() const
+{
+	const UGameInstance* GameInstance = GetGameInstance();
+	const ULocalPlayer* LocalPlayer = GameInstance ? GameInstance->GetFirstGamePlayer() : nullptr;
+	return LocalPlayer ? LocalPlayer->GetPreferredUniqueNetId() : FUniqueNetIdRepl();
+}
+
+void UMenuSystemSessionSubsystem::ClearSessionDelegates()
+{
+	if(!SessionBackend.IsValid()){
+		return;
+	}
+
+	//Clear_Handle also resets the handle, so it is safe to call this for operations that are not in flight
+	SessionBackend->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	SessionBackend->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+	SessionBackend->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+	SessionBackend->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+}
+
+EMenuSystemDiscoveryMode UMenuSystemSessionSubsystem::GetDiscoveryMode() const
+{
+	const int32 CVarMode = CVarMenuSystemDiscoveryMode.GetValueOnGameThread();
+	if(CVarMode >= 0 && CVarMode <= static_cast<int32>(EMenuSystemDiscoveryMode::Auto)){
+		return static_cast<EMenuSystemDiscoveryMode>(CVarMode);
+	}
+
+	//-LAN lets a second instance on the same machine (or a machine without the online service) host and join without any config
+	if(FParse::Param(FCommandLine::Get(), TEXT("LAN"))){
+		return EMenuSystemDiscoveryMode::LAN;
+	}
+	return DiscoveryMode;
+}
+
+TSharedPtr<FOnlineSessionSettings> UMenuSystemSessionSubsystem::MakeHostSessionSettings() const
+{
+	TSharedPtr<FOnlineSessionSettings> SessionSettings = MakeShareable(new FOnlineSessionSettings());
+
+	//a session is either advertised on the local network or through the online service. Auto hosts online, so every player can find them
+	//(though not through the LAN half of an Auto search)
+	const bool bLANMatch = GetDiscoveryMode() == EMenuSystemDiscoveryMode::LAN;
+
+	//LAN matches answer the search broadcasts of the local network instead of being advertised by the online service
+	SessionSettings->bIsLANMatch = bLANMatch;
+	//Determines how many player can connect to the game
+	SessionSettings->NumPublicConnections = FMath::Clamp(MaxPlayers, 1, 64);
+	//if a session is running, other players can join while that session is running
+	SessionSettings->bAllowJoinInProgress = true;
+	//steam uses presence to only connect us to players in the same region of the world
+	SessionSettings->bAllowJoinViaPresence = !bLANMatch;
+	//Allows steam to advertise the sessions so other player can find and join that session
+	SessionSettings->bShouldAdvertise = true;
+	//Allows us to use presence in order to find sessions going on in our region of the world. There is no presence on the local network
+	SessionSettings->bUsesPresence = !bLANMatch;
+	//If not use this, after building package, it will return "Create Session Failed"
+	SessionSettings->bUseLobbiesIfAvailable = !bLANMatch;
+	//the beacon port is only added by AdvertiseBeaconPort, once the lobby's beacon is listening
+	//Advertise the match type, region and build version, searching players filter on these keys through the backend
+	FMenuSystemSessionQuery()
+		.WithMatchType(HostMatchType)
+		.WithRegion(SessionRegion)
+		.WithLocalBuildVersion()
+		.AdvertiseIn(*SessionSettings);
+
+	return SessionSettings;
+}
+
+void UMenuSystemSessionSubsystem::AdvertiseBeaconPort(int32 BeaconPort)
+{
+	FOnlineSessionSettings* CurrentSettings = SessionBackend.IsValid() ? SessionBackend->GetSessionSettings(NAME_GameSession) : nullptr;
+	if(CurrentSettings == nullptr){
+		return;
+	}
+
+	int32 AdvertisedPort = 0;
+	CurrentSettings->Get(SETTING_BEACONPORT, AdvertisedPort);
+	if(AdvertisedPort == BeaconPort){
+		return;
+	}
+
+	//joining players reserve a slot through our beacon before they join and travel, a session without the key is joined directly
+	FOnlineSessionSettings UpdatedSettings = *CurrentSettings;
+	if(BeaconPort > 0){
+		UpdatedSettings.Set(SETTING_BEACONPORT, BeaconPort, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	}
+	else{
+		UpdatedSettings.Remove(SETTING_BEACONPORT);
+	}
+
+	if(!SessionBackend->UpdateSession(NAME_GameSession, UpdatedSettings)){
+		UE_LOG(LogMenuSystem, Warning, TEXT("Could not update the beacon port of the session to %d"), BeaconPort);
+	}
+}
+
+void UMenuSystemSessionSubsystem::CreateGameSession()
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_CreateGameSession);
+
+	if(!SessionBackend.IsValid()){
+		return;
+	}
+
+	//the host pipeline is still running, pressing the host key again must not start a second one
+	if(HostState != EMenuSystemHostState::Idle){
+		return;
+	}
+
+	//settle the settings before anything is sent, so the session is never advertised half configured
+	PendingSessionSettings = MakeHostSessionSettings();
+
+	//the lobby streams in while the session is being created, instead of all at once when we travel
+	PreloadLobbyAssets();
+
+	//if a session with this name already exists we have to wait for it to be destroyed, creating one before that would fail
+	if(SessionBackend->HasNamedSession(NAME_GameSession)){
+		HostState = EMenuSystemHostState::DestroyingSession;
+		DestroySessionCompleteDelegateHandle = SessionBackend->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+
+		FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::Destroy);
+		if(!SessionBackend->DestroySession(NAME_GameSession)){
+			FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Destroy, false);
+			SessionBackend->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+			HostState = EMenuSystemHostState::Idle;
+			PendingSessionSettings.Reset();
+			AbandonLobbyPreload();
+			OnCreateGameSessionComplete.Broadcast(false);
+		}
+		return;
+	}
+
+	StartCreateSession();
+}
+
+bool UMenuSystemSessionSubsystem::DestroyGameSession()
+{
+	//the host pipeline destroys the session it replaces itself, and a destroy already in flight will report
+	if(!SessionBackend.IsValid() || HostState != EMenuSystemHostState::Idle || DestroySessionCompleteDelegateHandle.IsValid() || !SessionBackend->HasNamedSession(NAME_GameSession)){
+		return false;
+	}
+
+	DestroySessionCompleteDelegateHandle = SessionBackend->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::Destroy);
+	if(!SessionBackend->DestroySession(NAME_GameSession)){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Destroy, false);
+		SessionBackend->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+		return false;
+	}
+	return true;
+}
+
+bool UMenuSystemSessionSubsystem::HasGameSession() const
+{
+	return SessionBackend.IsValid() && SessionBackend->HasNamedSession(NAME_GameSession);
+}
+
+void UMenuSystemSessionSubsystem::CancelSessionRequests()
+{
+	const bool bWasJoining = JoinSessionCompleteDelegateHandle.IsValid();
+
+	StopSessionSearch();
+	if(ReservationClient.IsValid()){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Reserve, false);
+	}
+	EndReservation();
+	JoinCandidates.Reset();
+	bJoinCandidatesFromCache = false;
+
+	//the backend may still complete them, but nobody waits for them any more and the next request must not be refused because of them
+	if(CreateSessionCompleteDelegateHandle.IsValid()){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Create, false);
+	}
+	if(DestroySessionCompleteDelegateHandle.IsValid()){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Destroy, false);
+	}
+	if(bWasJoining){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Join, false);
+	}
+	ClearSessionDelegates();
+	HostState = EMenuSystemHostState::Idle;
+	PendingSessionSettings.Reset();
+
+	//JoinSession only starts without a session of that name, so if there is one now it is the one we were joining
+	if(bWasJoining && HasGameSession()){
+		SessionBackend->DestroySession(NAME_GameSession);
+	}
+	AbandonLobbyPreload();
+}
+
+bool UMenuSystemSessionSubsystem::StartCreateSession()
+{
+	if(!SessionBackend.IsValid() || !PendingSessionSettings.IsValid()){
+		HostState = EMenuSystemHostState::Idle;
+		PendingSessionSettings.Reset();
+		return false;
+	}
+
+	HostState = EMenuSystemHostState::CreatingSession;
+
+	//add our delegate to the session backend delegate list, OnCreateSessionComplete is called once the session has been created
+	CreateSessionCompleteDelegateHandle = SessionBackend->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
+
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::Create);
+	if(!SessionBackend->CreateSession(GetSessionPlayerId(), NAME_GameSession, *PendingSessionSettings)){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Create, false);
+		//CreateSession failed straight away, so our callback will never fire. Remove it now or it would stay registered forever
+		SessionBackend->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+		HostState = EMenuSystemHostState::Idle;
+		PendingSessionSettings.Reset();
+		AbandonLobbyPreload();
+		OnCreateGameSessionComplete.Broadcast(false);
+		return false;
+	}
+	return true;
+}
+
+void UMenuSystemSessionSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_OnDestroySessionComplete);
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Destroy, bWasSuccessful);
+
+	if(SessionBackend.IsValid()){
+		SessionBackend->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+	}
+
+	//a session left through DestroyGameSession, not one the host pipeline replaces
+	if(HostState != EMenuSystemHostState::DestroyingSession){
+		OnDestroyGameSessionComplete.Broadcast(bWasSuccessful);
+		return;
+	}
+
+	if(bWasSuccessful){
+		//the old session is gone, now the new one can be created in the same round trip
+		StartCreateSession();
+	}
+	else {
+		HostState = EMenuSystemHostState::Idle;
+		PendingSessionSettings.Reset();
+
+		UE_LOG(LogMenuSystem, Warning, TEXT("Failed to destroy the previous session %s"), *SessionName.ToString());
+		AbandonLobbyPreload();
+		OnCreateGameSessionComplete.Broadcast(false);
+	}
+}
+
+void UMenuSystemSessionSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_OnCreateSessionComplete);
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Create, bWasSuccessful);
+
+	if(SessionBackend.IsValid()){
+		SessionBackend->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	}
+
+	HostState = EMenuSystemHostState::Idle;
+	PendingSessionSettings.Reset();
+	if(!bWasSuccessful){
+		AbandonLobbyPreload();
+	}
+	OnCreateGameSessionComplete.Broadcast(bWasSuccessful);
+
+	if(bWasSuccessful){
+		UE_LOG(LogMenuSystem, Log, TEXT("Created session %s"), *SessionName.ToString());
+
+		TravelToLobby();
+	}
+
+	else {
+		UE_LOG(LogMenuSystem, Warning, TEXT("Failed to create session %s"), *SessionName.ToString());
+	}
+}
+
+FMenuSystemSessionQuery UMenuSystemSessionSubsystem::MakeDefaultSessionQuery() const
+{
+	return FMenuSystemSessionQuery()
+		.WithMatchType(HostMatchType)
+		.WithRegion(SessionRegion)
+		.WithLocalBuildVersion()
+		.WithMinOpenSlots(1)
+		.WithLanQuery(GetDiscoveryMode() != EMenuSystemDiscoveryMode::Online);
+}
+
+void UMenuSystemSessionSubsystem::JoinGameSession(const FMenuSystemSessionQuery& Query)
+{
+	StartSessionSearch(Query, true);
+}
+
+void UMenuSystemSessionSubsystem::FindGameSessions(const FMenuSystemSessionQuery& Query)
+{
+	StartSessionSearch(Query, false);
+}
+
+void UMenuSystemSessionSubsystem::StartSessionSearch(const FMenuSystemSessionQuery& Query, bool bJoinWhenFound)
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_StartSessionSearch);
+
+	if(!SessionBackend.IsValid()){
+		return;
+	}
+
+	//we are already joining one of the results, a new search would only race with it
+	if(IsJoiningSession()){
+		return;
+	}
+
+	//a search is usually followed by a join, so the lobby streams in while we wait for the results
+	PreloadLobbyAssets();
+
+	if(IsSearchingSessions()){
+		//a search is already running, don't restart it. If we now want to join, check what the earlier pages already found
+		if(bJoinWhenFound && !bJoinFromSearch){
+			bJoinFromSearch = true;
+			if(JoinBestSearchResult()){
+				StopSessionSearch();
+			}
+		}
+		return;
+	}
+
+	SearchResults.Reset();
+	SearchResultIndices.Reset();
+	BackendResultIds.Reset();
+	JoinCandidates.Reset();
+	SearchQuery = Query;
+	SearchPageIndex = 0;
+	bJoinFromSearch = bJoinWhenFound;
+	bJoinCandidatesFromCache = false;
+	bFallBackToOnline = Query.bLanQuery && GetDiscoveryMode() == EMenuSystemDiscoveryMode::Auto;
+
+	if(ServeSearchFromCache()){
+		return;
+	}
+
+	if(!StartSearchPage()){
+		FinishSessionSearch(true);
+	}
+}
+
+bool UMenuSystemSessionSubsystem::ServeSearchFromCache()
+{
+	const FString CacheKey = SearchQuery.ToCacheKey();
+	const FMenuSystemCachedSessionSearch* CachedSearch = SearchCache.Find(CacheKey);
+	if(CachedSearch == nullptr){
+		return false;
+	}
+
+	const double CacheAge = FPlatformTime::Seconds() - CachedSearch->SearchTime;
+	if(CacheAge > SearchCacheMaxStaleSeconds){
+		SearchCache.Remove(CacheKey);
+		return false;
+	}
+
+	SearchResults = CachedSearch->Results;
+	for(int32 Index = 0; Index < SearchResults.Num(); Index++)
+	{
+		SearchResultIndices.Add(SearchResults[Index].GetSessionIdStr(), Index);
+	}
+
+	bJoinCandidatesFromCache = true;
+	const bool bJoined = bJoinFromSearch && JoinBestSearchResult();
+
+	//Auto discovery: the local network had nothing to join (or nothing at all when only listing) a moment ago, go on with the online service
+	//right away instead of broadcasting again
+	const bool bFallBack = bFallBackToOnline && CacheAge <= SearchCacheTTLSeconds && !bJoined && (bJoinFromSearch || SearchResults.Num() == 0);
+
+	//fresh results are the answer, stale ones are shown right away while the backend is asked again in the background.
+	//Once we are joining one of them there is nothing left to refresh them for, but if we wanted to join and none of them is joinable we have to ask
+	const bool bRefresh = !bJoined && !bFallBack && (bJoinFromSearch || CacheAge > SearchCacheTTLSeconds);
+	if(!bRefresh && !bFallBack){
+		SearchPageIndex = INDEX_NONE;
+		bJoinFromSearch = false;
+		bFallBackToOnline = false;
+	}
+
+	OnSessionSearchPage.Broadcast(TArrayView<const FOnlineSessionSearchResult>(SearchResults), !bRefresh && !bFallBack);
+
+	//done if there is nothing to refresh, or one of the listeners stopped the search
+	if((!bRefresh && !bFallBack) || !IsSearchingSessions()){
+		return true;
+	}
+
+	if(bFallBack){
+		FallBackToOnline();
+	}
+	else if(!StartSearchPage()){
+		FinishSessionSearch(true);
+	}
+	return true;
+}
+
+void UMenuSystemSessionSubsystem::UpdateSearchCache()
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_UpdateSearchCache);
+
+	FMenuSystemCachedSessionSearch& CachedSearch = SearchCache.FindOrAdd(SearchQuery.ToCacheKey());
+	CachedSearch.SearchTime = FPlatformTime::Seconds();
+
+	//only cache what the backend confirmed, sessions that came from an older cache entry and are not returned any more are gone
+	CachedSearch.Results.Reset(BackendResultIds.Num());
+	for(const FOnlineSessionSearchResult& Result : SearchResults)
+	{
+		if(BackendResultIds.Contains(Result.GetSessionIdStr())){
+			CachedSearch.Results.Add(Result);
+		}
+	}
+
+	while(SearchCache.Num() > FMath::Max(MaxCachedSearches, 1))
+	{
+		FString OldestKey;
+		double OldestTime = TNumericLimits<double>::Max();
+		for(const TPair<FString, FMenuSystemCachedSessionSearch>& Entry : SearchCache)
+		{
+			if(Entry.Value.SearchTime < OldestTime){
+				OldestTime = Entry.Value.SearchTime;
+				OldestKey = Entry.Key;
+			}
+		}
+		SearchCache.Remove(OldestKey);
+	}
+}
+
+TSharedRef<FOnlineSessionSearch> UMenuSystemSessionSubsystem::MakeSessionSearch(const FMenuSystemSessionQuery& Query, int32 PageIndex) const
+{
+	TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+	//start with a small page so the first sessions show up quickly, and only ask for more if they were not good enough
+	Search->MaxSearchResults = SearchPageSize << PageIndex;
+	//give up on a page once its time budget is spent instead of waiting for a slow backend
+	Search->TimeoutInSeconds = Query.bLanQuery ? LanSearchTimeoutSeconds : SearchPageTimeoutSeconds;
+	//broadcast on the local network, or ask the online service
+	Search->bIsLanQuery = Query.bLanQuery;
+	//online sessions use presence, so make sure that any sessions we find are using presence as well. LAN sessions have none
+	if(!Query.bLanQuery){
+		Search->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+	}
+	//let the backend drop the sessions we are not interested in, rather than downloading them to compare them here
+	Query.ApplyTo(*Search);
+	return Search;
+}
+
+bool UMenuSystemSessionSubsystem::StartSearchPage()
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_StartSearchPage);
+
+	if(!SessionBackend.IsValid()){
+		return false;
+	}
+
+	SessionSearch = MakeSessionSearch(SearchQuery, SearchPageIndex);
+
+	//add our delegate to the session backend delegate list, OnFindSessionsComplete is called once FindSessions() has completed
+	FindSessionsCompleteDelegateHandle = SessionBackend->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
+
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::Find);
+	if(!SessionBackend->FindSessions(GetSessionPlayerId(), SessionSearch.ToSharedRef())){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Find, false);
+		SessionBackend->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+		return false;
+	}
+
+	//the page may have completed right away
+	if(SearchQuery.bLanQuery && FindSessionsCompleteDelegateHandle.IsValid()){
+		LanSearchTimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnLanSearchTimeout), LanSearchTimeoutSeconds);
+	}
+	return true;
+}
+
+bool UMenuSystemSessionSubsystem::OnLanSearchTimeout(float DeltaTime)
+{
+	LanSearchTimeoutHandle.Reset();
+
+	if(!FindSessionsCompleteDelegateHandle.IsValid() || !SessionBackend.IsValid()){
+		return false;
+	}
+
+	//the LAN answers are added to the search as they arrive, so what we have is what the local network has to offer
+	SessionBackend->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+	SessionBackend->CancelFindSessions();
+	OnFindSessionsComplete(true);
+	return false;
+}
+
+void UMenuSystemSessionSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_OnFindSessionsComplete);
+
+	if(SessionBackend.IsValid()){
+		SessionBackend->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+	}
+	FTSTicker::GetCoreTicker().RemoveTicker(LanSearchTimeoutHandle);
+	LanSearchTimeoutHandle.Reset();
+
+	if(!SessionSearch.IsValid() || !IsSearchingSessions()){
+		return;
+	}
+
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Find, bWasSuccessful);
+	INC_DWORD_STAT_BY(STAT_MenuSystem_SearchResultsReceived, SessionSearch->SearchResults.Num());
+
+	//every page re-reports the sessions of the previous ones, only report the ones we haven't seen yet. The ones we have (from an earlier page
+	//or the cache) are replaced by what the backend reports now, their open slots and ping may have changed since
+	const int32 FirstNewIndex = SearchResults.Num();
+	for(FOnlineSessionSearchResult& Result : SessionSearch->SearchResults)
+	{
+		const FString SessionId = Result.GetSessionIdStr();
+		BackendResultIds.Add(SessionId);
+
+		if(const int32* ExistingIndex = SearchResultIndices.Find(SessionId)){
+			SearchResults[*ExistingIndex] = MoveTemp(Result);
+			continue;
+		}
+		SearchResultIndices.Add(SessionId, SearchResults.Num());
+		SearchResults.Add(MoveTemp(Result));
+	}
+	const int32 NumNewResults = SearchResults.Num() - FirstNewIndex;
+
+	UE_LOG(LogMenuSystem, Verbose, TEXT("Search page %d: %d results, %d new"), SearchPageIndex, SessionSearch->SearchResults.Num(), NumNewResults);
+
+	//fewer results than asked for means the backend has nothing more to give us. A LAN search gets every answer of the network at once
+	const bool bBackendExhausted = SessionSearch->bIsLanQuery || SessionSearch->SearchResults.Num() < SessionSearch->MaxSearchResults;
+	SessionSearch.Reset();
+
+	//the backend gave us everything it has, the cached sessions it did not return are gone. They were all added before this page,
+	//so the new results stay at the end
+	if(bWasSuccessful && bBackendExhausted && BackendResultIds.Num() < SearchResults.Num()){
+		SearchResults.RemoveAll([this](const FOnlineSessionSearchResult& Result){ return !BackendResultIds.Contains(Result.GetSessionIdStr()); });
+		SearchResultIndices.Reset();
+		for(int32 Index = 0; Index < SearchResults.Num(); Index++)
+		{
+			SearchResultIndices.Add(SearchResults[Index].GetSessionIdStr(), Index);
+		}
+	}
+
+	if(bWasSuccessful){
+		UpdateSearchCache();
+	}
+
+	bJoinCandidatesFromCache = false;
+	const bool bJoined = bJoinFromSearch && JoinBestSearchResult();
+	const bool bFinalPage = !bWasSuccessful || bJoined || bBackendExhausted || SearchPageIndex + 1 >= MaxSearchPages;
+
+	//Auto discovery: nothing to join on the local network (or nothing at all when only listing), so the search goes on with the online service
+	const bool bFallBack = bFallBackToOnline && !bJoined && (bJoinFromSearch || SearchResults.Num() == 0);
+
+	OnSessionSearchPage.Broadcast(TArrayView<const FOnlineSessionSearchResult>(SearchResults.GetData() + SearchResults.Num() - NumNewResults, NumNewResults), bFinalPage && !bFallBack);
+
+	//one of the listeners may have stopped the search already
+	if(!IsSearchingSessions()){
+		return;
+	}
+
+	if(bFallBack){
+		FallBackToOnline();
+		return;
+	}
+
+	if(bFinalPage){
+		FinishSessionSearch(false);
+		return;
+	}
+
+	++SearchPageIndex;
+	if(!StartSearchPage()){
+		FinishSessionSearch(true);
+	}
+}
+
+void UMenuSystemSessionSubsystem::FallBackToOnline()
+{
+	UE_LOG(LogMenuSystem, Verbose, TEXT("Nothing to join on the local network, searching online"));
+	SearchQuery.bLanQuery = false;
+	bFallBackToOnline = false;
+	SearchPageIndex = 0;
+
+	//the online search starts over: the LAN sessions were of no use, and must not end up in the cache entry of the online query
+	SearchResults.Reset();
+	SearchResultIndices.Reset();
+	BackendResultIds.Reset();
+	JoinCandidates.Reset();
+	bJoinCandidatesFromCache = false;
+
+	if(ServeSearchFromCache()){
+		return;
+	}
+
+	if(!StartSearchPage()){
+		FinishSessionSearch(true);
+	}
+}
+
+void UMenuSystemSessionSubsystem::StopSessionSearch()
+{
+	if(!IsSearchingSessions()){
+		return;
+	}
+
+	if(FindSessionsCompleteDelegateHandle.IsValid() && SessionBackend.IsValid()){
+		//we don't care about the page in flight any more
+		SessionBackend->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+		SessionBackend->CancelFindSessions();
+	}
+	FinishSessionSearch(true);
+}
+
+void UMenuSystemSessionSubsystem::FinishSessionSearch(bool bBroadcastFinalPage)
+{
+	//a search that was to join a session and ends without a join in flight found nothing to join
+	const bool bJoinFailed = bJoinFromSearch && !IsJoiningSession();
+
+	SearchPageIndex = INDEX_NONE;
+	bJoinFromSearch = false;
+	bFallBackToOnline = false;
+	SessionSearch.Reset();
+	FTSTicker::GetCoreTicker().RemoveTicker(LanSearchTimeoutHandle);
+	LanSearchTimeoutHandle.Reset();
+
+	//nothing to join. Found sessions keep the preload, the player may still pick one of them
+	if(bJoinFailed || SearchResults.Num() == 0){
+		AbandonLobbyPreload();
+	}
+
+	if(bBroadcastFinalPage){
+		OnSessionSearchPage.Broadcast(TArrayView<const FOnlineSessionSearchResult>(), true);
+	}
+	if(bJoinFailed){
+		OnJoinGameSessionComplete.Broadcast(false);
+	}
+}
+
+bool UMenuSystemSessionSubsystem::JoinBestSearchResult()
+{
+	{
+		MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_RankSearchResults);
+		//rank everything found so far. We only get here while none of it has been joinable, the best candidate is a new session or one that has a free slot again
+		SessionRanking.Rank(SearchResults, SearchQuery, JoinCandidates);
+	}
+	return JoinNextCandidate();
+}
+
+bool UMenuSystemSessionSubsystem::JoinNextCandidate()
+{
+	while(JoinCandidates.Num() > 0)
+	{
+		const FOnlineSessionSearchResult& Result = SearchResults[JoinCandidates[0]];
+		JoinCandidates.RemoveAt(0, 1, false);
+
+		UE_LOG(LogMenuSystem, Log, TEXT("Joining %s (%d ms, %d open slots)"), *Result.Session.OwningUserName, Result.PingInMs, Result.Session.NumOpenPublicConnections);
+		//only one join can be in flight, the remaining candidates are kept as fallbacks in case this one fails.
+		//Hosts with a beacon are asked for a slot first, the join starts once we have it
+		if(RequestReservation(Result) || JoinFoundSession(Result)){
+			return true;
+		}
+	}
+	return false;
+}
+
+void UMenuSystemSessionSubsystem::OnJoinCandidatesExhausted()
+{
+	//every candidate came from an old cache entry, they are probably gone. Drop it and ask the backend
+	if(bJoinCandidatesFromCache){
+		bJoinCandidatesFromCache = false;
+		SearchCache.Remove(SearchQuery.ToCacheKey());
+		JoinGameSession(SearchQuery);
+		return;
+	}
+
+	UE_LOG(LogMenuSystem, Warning, TEXT("No session left to join"));
+	AbandonLobbyPreload();
+	OnJoinGameSessionComplete.Broadcast(false);
+}
+
+bool UMenuSystemSessionSubsystem::UsesReservationBeacons() const
+{
+	return bUseReservationBeacons && AMenuSystemReservationBeaconHostObject::IsBeaconNetDriverConfigured();
+}
+
+bool UMenuSystemSessionSubsystem::IsJoiningSession() const
+{
+	return JoinSessionCompleteDelegateHandle.IsValid() || ReservationClient.IsValid();
+}
+
+bool UMenuSystemSessionSubsystem::RequestReservation(const FOnlineSessionSearchResult& SearchResult)
+{
+	//hosts that don't advertise a beacon are joined directly. So is every host when we have no unique id, reservations are kept under the id we log in with
+	int32 BeaconPort = 0;
+	const FUniqueNetIdRepl PlayerId = GetSessionPlayerId();
+	if(!UsesReservationBeacons() || !SessionBackend.IsValid() || IsJoiningSession() || !PlayerId.IsValid() || !SearchResult.Session.SessionSettings.Get(SETTING_BEACONPORT, BeaconPort)){
+		return false;
+	}
+
+	FString BeaconAddress;
+	UWorld* World = GetWorld();
+	if(World == nullptr || !SessionBackend->GetResolvedConnectString(SearchResult, NAME_BeaconPort, BeaconAddress)){
+		return false;
+	}
+
+	AMenuSystemReservationBeaconClient* Client = World->SpawnActor<AMenuSystemReservationBeaconClient>(AMenuSystemReservationBeaconClient::StaticClass());
+	if(Client == nullptr){
+		return false;
+	}
+
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::Reserve);
+	if(!Client->RequestReservation(BeaconAddress, PlayerId)){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Reserve, false);
+		Client->DestroyBeacon();
+		return false;
+	}
+
+	Client->OnReservationResponse.BindUObject(this, &ThisClass::OnReservationResponse);
+	ReservationClient = Client;
+	ReservationSearchResult = SearchResult;
+	ReservationTimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::OnReservationTimeout), ReservationTimeoutSeconds);
+	return true;
+}
+
+bool UMenuSystemSessionSubsystem::OnReservationTimeout(float DeltaTime)
+{
+	ReservationTimeoutHandle.Reset();
+	OnReservationResponse(EMenuSystemReservationResult::ConnectionFailed, 0, 0);
+	return false;
+}
+
+void UMenuSystemSessionSubsystem::OnReservationResponse(EMenuSystemReservationResult Result, int32 Occupancy, int32 Capacity)
+{
+	const FOnlineSessionSearchResult SearchResult = MoveTemp(ReservationSearchResult);
+	EndReservation();
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Reserve, Result == EMenuSystemReservationResult::Accepted);
+
+	switch(Result)
+	{
+		case EMenuSystemReservationResult::Accepted:
+			UE_LOG(LogMenuSystem, Log, TEXT("Reserved a slot on %s (%d/%d)"), *SearchResult.Session.OwningUserName, Occupancy, Capacity);
+			if(JoinFoundSession(SearchResult)){
+				return;
+			}
+			break;
+
+		case EMenuSystemReservationResult::SessionFull:
+			UE_LOG(LogMenuSystem, Log, TEXT("%s is full (%d/%d)"), *SearchResult.Session.OwningUserName, Occupancy, Capacity);
+			break;
+
+		case EMenuSystemReservationResult::NotHosting:
+			UE_LOG(LogMenuSystem, Log, TEXT("%s is not hosting any more"), *SearchResult.Session.OwningUserName);
+			break;
+
+		case EMenuSystemReservationResult::InvalidPlayerId:
+			//the host does not know us by the id we have, try our luck with a free slot the way hosts without a beacon are joined
+			UE_LOG(LogMenuSystem, Log, TEXT("%s can't reserve a slot for our player id, joining without a reservation"), *SearchResult.Session.OwningUserName);
+			if(JoinFoundSession(SearchResult)){
+				return;
+			}
+			break;
+
+		default:
+			//it advertised a beacon, so no answer means the host is gone
+			UE_LOG(LogMenuSystem, Log, TEXT("No answer from the beacon of %s"), *SearchResult.Session.OwningUserName);
+			break;
+	}
+
+	if(!JoinNextCandidate()){
+		OnJoinCandidatesExhausted();
+	}
+}
+
+void UMenuSystemSessionSubsystem::EndReservation()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(ReservationTimeoutHandle);
+	ReservationTimeoutHandle.Reset();
+
+	if(AMenuSystemReservationBeaconClient* Client = ReservationClient.Get()){
+		Client->OnReservationResponse.Unbind();
+		//we may be inside one of its RPCs, its net driver goes away on the next tick
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateWeakLambda(Client, [Client](float){
+			Client->DestroyBeacon();
+			return false;
+		}));
+	}
+	ReservationClient.Reset();
+}
+
+bool UMenuSystemSessionSubsystem::JoinFoundSession(const FOnlineSessionSearchResult& SearchResult)
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_JoinSession);
+
+	if(!SessionBackend.IsValid() || JoinSessionCompleteDelegateHandle.IsValid()){
+		return false;
+	}
+
+	//add our delegate to the session backend delegate list, OnJoinSessionComplete is called once joining the session has completed
+	JoinSessionCompleteDelegateHandle = SessionBackend->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::Join);
+	if(!SessionBackend->JoinSession(GetSessionPlayerId(), NAME_GameSession, SearchResult)){
+		FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Join, false);
+		SessionBackend->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+		return false;
+	}
+	return true;
+}
+
+void UMenuSystemSessionSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_OnJoinSessionComplete);
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::Join, Result == EOnJoinSessionCompleteResult::Success);
+
+	if(!SessionBackend.IsValid()){
+		return;
+	}
+
+	SessionBackend->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+
+	if(Result != EOnJoinSessionCompleteResult::Success){
+		UE_LOG(LogMenuSystem, Log, TEXT("Failed to join a session (%s)"), LexToString(Result));
+
+		//the session was full or gone by the time we got there, move on to the next best one
+		if(!JoinNextCandidate()){
+			OnJoinCandidatesExhausted();
+		}
+		return;
+	}
+
+	JoinCandidates.Reset();
+
+	FString Address;
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::ResolveConnectString);
+	const bool bResolved = SessionBackend->GetResolvedConnectString(NAME_GameSession, Address);		//returns the platform specific connection information (like the IP address) for joining the match
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::ResolveConnectString, bResolved);
+	if(bResolved){
+		UE_LOG(LogMenuSystem, Log, TEXT("Connect String on Address: %s"), *Address);
+
+		APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
+		if(PlayerController){
+			//joining stays a TRAVEL_Absolute ClientTravel: connecting to a new server can't be seamless, only the host's travels to the lobby
+			//(with the players already connected) go through the transition map
+			FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::ClientTravel);
+			PlayerController->ClientTravel(Address, ETravelType::TRAVEL_Absolute);		//travel to the address we got from GetResolvedConnectString()
+		}
+	}
+	else{
+		UE_LOG(LogMenuSystem, Warning, TEXT("Could not resolve the address of session %s"), *SessionName.ToString());
+		AbandonLobbyPreload();
+	}
+	OnJoinGameSessionComplete.Broadcast(bResolved);
+}
+
+void UMenuSystemSessionSubsystem::TravelToLobby()
+{
+	UWorld* World = GetWorld();
+	if(World == nullptr){
+		return;
+	}
+
+	//the game session of the lobby reads its capacity from MaxPlayers
+	FString LobbyURL = FString::Printf(TEXT("%s?MaxPlayers=%d"), *LobbyMap, FMath::Clamp(MaxPlayers, 1, 64));
+
+	//seamless travel needs a game mode that allows it, and is not supported by PIE
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	bool bSeamless = bSeamlessLobbyTravel && GameMode && GameMode->bUseSeamlessTravel && !World->IsPlayInEditor();
+
+	//seamless travel keeps the net driver of the world it leaves, so a standalone host must start listening before it leaves.
+	//A hard travel opens a new world that starts listening because of ?listen
+	if(bSeamless && World->GetNetMode() == NM_Standalone){
+		FURL ListenURL;
+		ListenURL.AddOption(TEXT("listen"));
+		if(!World->Listen(ListenURL)){
+			UE_LOG(LogMenuSystem, Warning, TEXT("Could not listen before the seamless travel, travelling the hard way"));
+			bSeamless = false;
+		}
+	}
+	if(!bSeamless){
+		LobbyURL += TEXT("?listen");
+	}
+
+	//a seamless ServerTravel keeps the clients connected, along with their controllers and player states
+	FMenuSystemSessionCounters::Begin(EMenuSystemSessionOp::ServerTravel);
+	World->ServerTravel(LobbyURL);
+}
+
+bool UMenuSystemSessionSubsystem::IsTransitionWorld(const UWorld* World) const
+{
+	//the transition map is a project setting (DefaultEngine.ini), without one the engine hops through an empty world
+	const FString TransitionMapName = GetDefault<UGameMapsSettings>()->TransitionMap.GetLongPackageName();
+	return World && !TransitionMapName.IsEmpty() && World->GetOutermost()->GetName() == TransitionMapName;
+}
+
+void UMenuSystemSessionSubsystem::PreloadLobbyAssets()
+{
+	MENUSYSTEM_SESSION_SCOPE(STAT_MenuSystem_PreloadLobbyAssets);
+
+	//already preloading (or preloaded) for the coming travel
+	if(!bPreloadLobbyAssets || LobbyPreloadHandle.IsValid()){
+		return;
+	}
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+	for(const FSoftObjectPath& Asset : LobbyPreloadAssets)
+	{
+		if(!Asset.IsNull()){
+			AssetsToLoad.AddUnique(Asset);
+		}
+	}
+
+	//the game mode only holds a soft reference to the pawn it spawns, so the map doesn't pull it in
+	const FSoftObjectPath DefaultPawnClass = GetDefault<AMenuSystemGameMode>()->DefaultPawnSoftClass.ToSoftObjectPath();
+	if(!DefaultPawnClass.IsNull()){
+		AssetsToLoad.AddUnique(DefaultPawnClass);
+	}
+
+	//the assets the lobby map references directly. The map itself is left to the travel, a world must be loaded by the travel that initializes it.
+	//A cooked build's asset registry only has package dependencies with [AssetRegistry] bSerializeDependencies=True in DefaultEngine.ini,
+	//without it only the assets above are preloaded
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	TArray<FName> Dependencies;
+	AssetRegistry.GetDependencies(FName(*LobbyMap), Dependencies, UE::AssetRegistry::EDependencyCategory::Package, UE::AssetRegistry::EDependencyQuery::Hard);
+	if(Dependencies.Num() == 0){
+		UE_LOG(LogMenuSystem, Verbose, TEXT("The asset registry has no dependencies of %s, only LobbyPreloadAssets and the pawn are preloaded"), *LobbyMap);
+	}
+	for(const FName& Dependency : Dependencies)
+	{
+		//native classes are always loaded
+		if(FPackageName::IsScriptPackage(Dependency.ToString())){
+			continue;
+		}
+
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(Dependency, Assets);
+		for(const FAssetData& Asset : Assets)
+		{
+			AssetsToLoad.AddUnique(FSoftObjectPath(Asset.ObjectPath));
+		}
+	}
+
+	if(AssetsToLoad.Num() == 0){
+		return;
+	}
+
+	UE_LOG(LogMenuSystem, Verbose, TEXT("Preloading %d assets of %s"), AssetsToLoad.Num(), *LobbyMap);
+
+	//below the priority of the loads the current map may still be doing, the player is in a menu while this runs
+	LobbyPreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate(), FStreamableManager::AsyncLoadLowPriority);
+}
+
+void UMenuSystemSessionSubsystem::AbandonLobbyPreload()
+{
+	//hosting and joining share the preload, the other one may still travel to the lobby
+	if(HostState != EMenuSystemHostState::Idle || IsSearchingSessions() || IsJoiningSession()){
+		return;
+	}
+	ReleaseLobbyPreload();
+}
+
+void UMenuSystemSessionSubsystem::ReleaseLobbyPreload()
+{
+	if(LobbyPreloadHandle.IsValid()){
+		//an unfinished load completes anyway, it just stops being kept in memory
+		LobbyPreloadHandle->ReleaseHandle();
+		LobbyPreloadHandle.Reset();
+	}
+}
+
+void UMenuSystemSessionSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	//a seamless travel loads the transition map first, the travel only ends with the destination
+	if(IsTransitionWorld(LoadedWorld)){
+		return;
+	}
+
+	//the loaded map references what it needs now, or the travel went somewhere else and the preload is of no use
+	ReleaseLobbyPreload();
+
+	//only the travels we started are being timed, End ignores the others
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::ServerTravel, true);
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::ClientTravel, true);
+}
+
+void UMenuSystemSessionSubsystem::OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString)
+{
+	UE_LOG(LogMenuSystem, Warning, TEXT("Travel failed (%s): %s"), ETravelFailure::ToString(FailureType), *ErrorString);
+	ReleaseLobbyPreload();
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::ServerTravel, false);
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::ClientTravel, false);
+}
+
+void UMenuSystemSessionSubsystem::OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+{
+	//a client that can't reach the host fails here rather than with a travel failure
+	FMenuSystemSessionCounters::End(EMenuSystemSessionOp::ClientTravel, false);
+}
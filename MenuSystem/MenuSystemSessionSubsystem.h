@@ -0,0 +1,409 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Engine/EngineBaseTypes.h"
+#include "OnlineSessionSettings.h"
+#include "MenuSystemSessionBackend.h"
+#include "MenuSystemSessionQuery.h"
+#include "MenuSystemSessionRanking.h"
+#include "MenuSystemSessionSubsystem.generated.h"
+
+class UNetDriver;
+class AMenuSystemReservationBeaconClient;
+struct FStreamableHandle;
+enum class EMenuSystemReservationResult : uint8;
+
+/** Steps of the host pipeline: DestroySession (only if a session exists) -> CreateSession -> ServerTravel (seamless if possible). */
+enum class EMenuSystemHostState : uint8
+{
+	Idle,
+	DestroyingSession,		// waiting for OnDestroySessionComplete before the new session can be created
+	CreatingSession			// waiting for OnCreateSessionComplete before we can travel to the lobby
+};
+
+/** How sessions are advertised and discovered. */
+UENUM()
+enum class EMenuSystemDiscoveryMode : uint8
+{
+	Online,		// through the online service (Steam lobbies)
+	LAN,		// by broadcasting on the local network, no online service needed. Only machines on the same network see the sessions
+	Auto		// hosts advertise online; searches broadcast on the local network first (for LAN hosts) and fall back to the online service if that finds nothing to join.
+				// Online hosts don't answer LAN broadcasts, so without a LAN host every search pays LanSearchTimeoutSeconds before going online
+};
+
+/**
+ * Broadcast once per page of a session search, as soon as the page arrives.
+ * NewResults only holds the sessions that were not reported by an earlier page of the same search, bFinalPage is true for the last broadcast of a search.
+ */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMenuSystemOnSessionSearchPage, TArrayView<const FOnlineSessionSearchResult> /*NewResults*/, bool /*bFinalPage*/);
+
+/** Broadcast once a host, join or leave request has been carried out (or given up on), see OnCreateGameSessionComplete and the others. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FMenuSystemOnGameSessionComplete, bool /*bWasSuccessful*/);
+
+/** Results of a finished search, kept so the next search with the same query can be answered without a round trip. */
+struct FMenuSystemCachedSessionSearch
+{
+	TArray<FOnlineSessionSearchResult> Results;
+
+	// FPlatformTime::Seconds() when the results were received
+	double SearchTime = 0.;
+};
+
+/**
+ * Owns everything related to online sessions (the session backend, the delegates and the search results).
+ * It lives on the GameInstance, so it is created once per process and survives ServerTravel/ClientTravel,
+ * unlike the pawn that used to hold this state. Characters and widgets only forward their requests to it.
+ */
+UCLASS(config=Game)
+class UMenuSystemSessionSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+	// The session benchmark sets the backend and the loopback tuning of its headless game instances on our defaults.
+	friend class UMenuSystemSessionBenchmarkCommandlet;
+
+	// The search cache spec ages the cached searches and runs against a loopback backend of its own.
+	friend class FMenuSystemSessionSearchCacheSpec;
+
+public:
+	UMenuSystemSessionSubsystem();
+
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	/** Hosts a new game session (destroying any existing one first) and travels to the lobby as a listen server once it is created. */
+	void CreateGameSession();
+
+	/** Returns the step the host pipeline is currently waiting on. */
+	EMenuSystemHostState GetHostState() const { return HostState; }
+
+	/** Leaves the session we joined, or ends the one we host. Returns false if there is none, or the host pipeline is busy with it. */
+	bool DestroyGameSession();
+
+	/** Returns true if we host or joined a session. */
+	bool HasGameSession() const;
+
+	/**
+	 * Gives up on every host, join and leave request in flight (search, reservation and backend operations), e.g. once the caller
+	 * stopped waiting for them. Nothing is broadcast for them any more, and a session we were joining is left.
+	 */
+	void CancelSessionRequests();
+
+	/** Searches for game sessions page by page and joins the best one of the first page that has a joinable session, without waiting for the remaining pages. */
+	void JoinGameSession(const FMenuSystemSessionQuery& Query);
+	void JoinGameSession() { JoinGameSession(MakeDefaultSessionQuery()); }
+
+	/** Searches for game sessions page by page without joining any of them. Bind OnSessionSearchPage to receive the results as they arrive. */
+	void FindGameSessions(const FMenuSystemSessionQuery& Query);
+	void FindGameSessions() { FindGameSessions(MakeDefaultSessionQuery()); }
+
+	/** The query used when none is given: our match type and region, our build, at least one open slot, and a LAN query unless the discovery mode is Online. */
+	FMenuSystemSessionQuery MakeDefaultSessionQuery() const;
+
+	/** Fills in the settings we advertise when hosting. They must be complete before CreateSession is called. */
+	TSharedPtr<FOnlineSessionSettings> MakeHostSessionSettings() const;
+
+	/** Builds the FindSessions request for one page of a search with the given query. */
+	TSharedRef<FOnlineSessionSearch> MakeSessionSearch(const FMenuSystemSessionQuery& Query, int32 PageIndex) const;
+
+	/** Returns the discovery mode in effect: MenuSystem.Session.DiscoveryMode if set, else LAN with -LAN on the command line, else DiscoveryMode. */
+	EMenuSystemDiscoveryMode GetDiscoveryMode() const;
+
+	/** Changes the discovery mode of the next host/search. MenuSystem.Session.DiscoveryMode still wins when set. */
+	void SetDiscoveryMode(EMenuSystemDiscoveryMode InDiscoveryMode) { DiscoveryMode = InDiscoveryMode; }
+
+	/** Returns true if hosts run a reservation beacon and clients reserve a slot through it before joining. Needs the BeaconNetDriver in the engine config. */
+	bool UsesReservationBeacons() const;
+
+	/** Advertises the port our reservation beacon listens on under SETTING_BEACONPORT, or stops advertising a beacon if 0. Only affects a session we host */
+	void AdvertiseBeaconPort(int32 BeaconPort);
+
+	/** The loopback backend tuning from our config */
+	FMenuSystemLoopbackSettings MakeLoopbackSettings() const;
+
+	/** Stops the running search early, e.g. once the player picked a session. OnSessionSearchPage receives a final (empty) page. */
+	void StopSessionSearch();
+
+	/** Forgets every cached search, so the next search goes to the backend. */
+	void ClearSearchCache() { SearchCache.Reset(); }
+
+	/** Returns true while a session search has pages left to fetch. */
+	bool IsSearchingSessions() const { return SearchPageIndex != INDEX_NONE; }
+
+	/** All the results of the current (or last) search, in the order they arrived, each with the latest values the backend reported. */
+	const TArray<FOnlineSessionSearchResult>& GetSearchResults() const { return SearchResults; }
+
+	/** Fired for every page of search results, see FMenuSystemOnSessionSearchPage. */
+	FMenuSystemOnSessionSearchPage OnSessionSearchPage;
+
+	/** Fired when the host pipeline ends: true once the session exists (the lobby travel starts right after), false if it could not be created. */
+	FMenuSystemOnGameSessionComplete OnCreateGameSessionComplete;
+
+	/** Fired when JoinGameSession ends: true once a session is joined and its address resolved (the client travel starts right after), false if nothing could be joined. */
+	FMenuSystemOnGameSessionComplete OnJoinGameSessionComplete;
+
+	/** Fired when the session DestroyGameSession left or ended is gone. */
+	FMenuSystemOnGameSessionComplete OnDestroyGameSessionComplete;
+
+protected:
+	// Callbacks bound to the delegates below, fired by the session backend when the matching operation completes.
+	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnFindSessionsComplete(bool bWasSuccessful);
+	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+
+	// Travel notifications of the engine, they end the ServerTravel/ClientTravel we started.
+	void OnPostLoadMap(UWorld* LoadedWorld);
+	void OnTravelFailure(UWorld* World, ETravelFailure::Type FailureType, const FString& ErrorString);
+	void OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString);
+
+private:
+	/** Creates the backend named by SessionBackendName (or -SessionBackend= on the command line). */
+	TSharedPtr<IMenuSystemSessionBackend> CreateSessionBackend() const;
+
+	/** Returns the id of the local player hosting/searching/joining. Invalid when there is no local player (headless), the backend then uses local user 0. */
+	FUniqueNetIdRepl GetSessionPlayerId() const;
+
+	/** Travels to the lobby as a listen server, seamlessly when we can. The last step of the host pipeline. */
+	void TravelToLobby();
+
+	/** Returns true if the world is the transition map of a seamless travel. */
+	bool IsTransitionWorld(const UWorld* World) const;
+
+	/** Starts streaming in the assets of the lobby in the background, so the travel only has to load what is left. Does nothing if a preload is already held. */
+	void PreloadLobbyAssets();
+
+	/** Stops keeping the preloaded lobby assets in memory. */
+	void ReleaseLobbyPreload();
+
+	/** Releases the lobby preload after a host, search or join failed, unless another of them still leads to the lobby. */
+	void AbandonLobbyPreload();
+
+	/** Starts CreateSession with PendingSessionSettings, the last step before travelling. Returns false (and resets the pipeline) if it could not be started. */
+	bool StartCreateSession();
+
+	/** Starts a new paged search. If one is already running, a join request is folded into it instead of starting over. */
+	void StartSessionSearch(const FMenuSystemSessionQuery& Query, bool bJoinWhenFound);
+
+	/** Sends the FindSessions request for SearchPageIndex. Returns false if the request could not be started. */
+	bool StartSearchPage();
+
+	/** Ends a LAN page that has not completed within LanSearchTimeoutSeconds with the sessions that answered so far. */
+	bool OnLanSearchTimeout(float DeltaTime);
+
+	/** Continues an Auto discovery search with the online service, from the online cache if it has an entry for the query. */
+	void FallBackToOnline();
+
+	/** Answers the search from SearchCache if it has results for SearchQuery that are not too old. Returns true if the search is complete without a backend round trip. */
+	bool ServeSearchFromCache();
+
+	/** Stores the results the backend returned for the current search in SearchCache. */
+	void UpdateSearchCache();
+
+	/** Ends the current search, broadcasting a final empty page if the listeners have not received one yet. */
+	void FinishSessionSearch(bool bBroadcastFinalPage);
+
+	/** Ranks SearchResults and joins the best candidate. Returns true if a join was started. */
+	bool JoinBestSearchResult();
+
+	/** Joins the best candidate left in JoinCandidates, used again as a fallback when a join fails. Returns true if a join was started. */
+	bool JoinNextCandidate();
+
+	/** Called when the last join candidate failed: searches the backend again if the candidates came from the cache, otherwise gives up. */
+	void OnJoinCandidatesExhausted();
+
+	/** Asks the host of a search result for a slot through its reservation beacon. Returns false if the host has no beacon or it can't be reached, the caller then joins directly. */
+	bool RequestReservation(const FOnlineSessionSearchResult& SearchResult);
+
+	/** Answer of the host to RequestReservation: joins the session if we got a slot, otherwise moves on to the next candidate. */
+	void OnReservationResponse(EMenuSystemReservationResult Result, int32 Occupancy, int32 Capacity);
+
+	/** Gives up on a host whose beacon did not answer within ReservationTimeoutSeconds. */
+	bool OnReservationTimeout(float DeltaTime);
+
+	/** Tears down the reservation beacon client and its timeout. */
+	void EndReservation();
+
+	/** Returns true while a reservation or a join is in flight. */
+	bool IsJoiningSession() const;
+
+	/** Joins the given search result unless a join is already in flight. Returns true if the join was started. */
+	bool JoinFoundSession(const FOnlineSessionSearchResult& SearchResult);
+
+	/** Removes every delegate we still have registered on the session backend. */
+	void ClearSessionDelegates();
+
+	// The backend all session operations go through, created once in Initialize.
+	TSharedPtr<IMenuSystemSessionBackend> SessionBackend;
+
+	// Delegates bound to our callbacks in the constructor and added to the session backend delegate lists when needed.
+	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
+	FOnDestroySessionCompleteDelegate DestroySessionCompleteDelegate;
+	FOnFindSessionsCompleteDelegate FindSessionsCompleteDelegate;
+	FOnJoinSessionCompleteDelegate JoinSessionCompleteDelegate;
+
+	// Handles returned when adding the delegates above. Each one is only valid while its operation is in flight,
+	// it is cleared in the matching On*Complete callback so a delegate is never registered more than once.
+	FDelegateHandle CreateSessionCompleteDelegateHandle;
+	FDelegateHandle DestroySessionCompleteDelegateHandle;
+	FDelegateHandle FindSessionsCompleteDelegateHandle;
+	FDelegateHandle JoinSessionCompleteDelegateHandle;
+
+	// Handles of the engine travel notifications, registered for the lifetime of the subsystem.
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle TravelFailureHandle;
+	FDelegateHandle NetworkFailureHandle;
+
+	// Keeps the preloaded lobby assets in memory until the next map is loaded.
+	TSharedPtr<FStreamableHandle> LobbyPreloadHandle;
+
+	// Where the host pipeline currently is, CreateGameSession is ignored unless this is Idle.
+	EMenuSystemHostState HostState = EMenuSystemHostState::Idle;
+
+	// Settings of the session we are about to create, kept while we wait for the old session to be destroyed.
+	TSharedPtr<FOnlineSessionSettings> PendingSessionSettings;
+
+	// The search of the page in flight; kept as a member since the results are read back in OnFindSessionsComplete.
+	TSharedPtr<FOnlineSessionSearch> SessionSearch;
+
+	// Results of every page of the current search, without duplicates. Moved out of SessionSearch as each page arrives,
+	// a session the backend reports again replaces the copy we had (from an earlier page or the cache) with its current slots and ping.
+	TArray<FOnlineSessionSearchResult> SearchResults;
+
+	// Index in SearchResults of every session id, since every page re-reports the sessions of the previous ones.
+	TMap<FString, int32> SearchResultIndices;
+
+	// Query of the current search, applied to the QuerySettings of every page.
+	FMenuSystemSessionQuery SearchQuery;
+
+	// Page of the current search, INDEX_NONE when no search is running.
+	int32 SearchPageIndex = INDEX_NONE;
+
+	// Session ids the backend returned during the current search. SearchResults can also hold sessions that only came from the cache.
+	TSet<FString> BackendResultIds;
+
+	// Recent search results per FMenuSystemSessionQuery::ToCacheKey().
+	TMap<FString, FMenuSystemCachedSessionSearch> SearchCache;
+
+	// Whether the current search continues with the online service if its LAN page finds nothing to join (Auto discovery).
+	bool bFallBackToOnline = false;
+
+	// Ends the LAN page in flight once LanSearchTimeoutSeconds have passed, some backends wait much longer for LAN answers.
+	FTSTicker::FDelegateHandle LanSearchTimeoutHandle;
+
+	// Whether JoinCandidates were ranked from cached results only, in which case we search the backend again if all of them fail.
+	bool bJoinCandidatesFromCache = false;
+
+	// Indices into SearchResults of the sessions we can still fall back to, best first.
+	TArray<int32> JoinCandidates;
+
+	// Scores the search results to pick the session to join.
+	FMenuSystemSessionRanking SessionRanking;
+
+	// Beacon client of the reservation in flight, and the session it is for.
+	TWeakObjectPtr<AMenuSystemReservationBeaconClient> ReservationClient;
+	FOnlineSessionSearchResult ReservationSearchResult;
+	FTSTicker::FDelegateHandle ReservationTimeoutHandle;
+
+	// Whether the current search joins the first matching session it finds (JoinGameSession) or only lists them (FindGameSessions).
+	bool bJoinFromSearch = false;
+
+	// Backend the session operations go through: an online subsystem name (empty means the default one, i.e. Steam) or "Loopback"
+	// for the in-process stand-in used by CI and load tests. -SessionBackend=<Name> on the command line overrides it.
+	UPROPERTY(Config)
+	FString SessionBackendName;
+
+	// Tuning of the loopback backend, see FMenuSystemLoopbackSettings.
+	UPROPERTY(Config)
+	float LoopbackLatencyMs = 50.f;
+
+	UPROPERTY(Config)
+	float LoopbackLatencyJitterMs = 0.f;
+
+	UPROPERTY(Config)
+	float LoopbackFailureRate = 0.f;
+
+	UPROPERTY(Config)
+	int32 LoopbackSyntheticSessionCount = 0;
+
+	UPROPERTY(Config)
+	int32 LoopbackRandomSeed = 0;
+
+	// Players a hosted lobby takes, host included. Advertised as the session's public connections and passed to the lobby's
+	// game session, so both agree on when the lobby is full. Lobbies past a handful of players rely on UMenuSystemReplicationGraph.
+	UPROPERTY(Config, meta=(ClampMin=1, ClampMax=64))
+	int32 MaxPlayers = 4;
+
+	// Map the host travels to once the session is created.
+	UPROPERTY(Config)
+	FString LobbyMap = TEXT("/Game/ThirdPerson/Maps/Lobby");
+
+	// Travel to the lobby seamlessly (if the current game mode allows it), so the transition is not a full world teardown and reload.
+	// It goes through the TransitionMap of [/Script/EngineSettings.GameMapsSettings] in DefaultEngine.ini.
+	UPROPERTY(Config)
+	bool bSeamlessLobbyTravel = true;
+
+	// Stream in the assets of LobbyMap (its hard references, the game mode's pawn and LobbyPreloadAssets) while a session is being created or searched for.
+	// Cooked builds only know the map's references with [AssetRegistry] bSerializeDependencies=True, list them in LobbyPreloadAssets otherwise.
+	UPROPERTY(Config)
+	bool bPreloadLobbyAssets = true;
+
+	// Assets the lobby needs that the map doesn't reference (or the asset registry doesn't know it references), e.g. soft references of its actors.
+	UPROPERTY(Config)
+	TArray<FSoftObjectPath> LobbyPreloadAssets;
+
+	// How sessions are advertised and discovered, see EMenuSystemDiscoveryMode. Auto only pays off where LAN hosts are expected.
+	UPROPERTY(Config)
+	EMenuSystemDiscoveryMode DiscoveryMode = EMenuSystemDiscoveryMode::Online;
+
+	// Time LAN hosts get to answer a search broadcast. They are on the same network, the ones that exist answer within milliseconds.
+	UPROPERTY(Config)
+	float LanSearchTimeoutSeconds = 0.5f;
+
+	// Hosts run a reservation beacon (advertised under SETTING_BEACONPORT once it listens), and clients reserve a slot through it before joining,
+	// so a full or gone host is skipped after one small round trip instead of a join, a connection and a map load.
+	UPROPERTY(Config)
+	bool bUseReservationBeacons = true;
+
+	// Time a host's beacon gets to answer before we move on to the next candidate.
+	UPROPERTY(Config)
+	float ReservationTimeoutSeconds = 3.f;
+
+	// Match type we advertise when hosting, and look for when joining.
+	UPROPERTY(Config)
+	FString HostMatchType = TEXT("FreeForAll");
+
+	// Region we advertise when hosting and look for when joining. Empty means sessions are not filtered by region.
+	UPROPERTY(Config)
+	FString SessionRegion;
+
+	// Age up to which cached results are used as they are, without asking the backend again.
+	UPROPERTY(Config)
+	float SearchCacheTTLSeconds = 10.f;
+
+	// Age up to which stale cached results are still shown/joined right away while a refresh runs in the background. Older ones are dropped.
+	UPROPERTY(Config)
+	float SearchCacheMaxStaleSeconds = 60.f;
+
+	// Number of different queries kept in the cache, the oldest one is dropped first.
+	UPROPERTY(Config)
+	int32 MaxCachedSearches = 8;
+
+	// Number of results asked for by the first page. Every following page asks for twice as many as the previous one.
+	UPROPERTY(Config)
+	int32 SearchPageSize = 20;
+
+	// Number of pages after which a search gives up, even if the backend still has results.
+	UPROPERTY(Config)
+	int32 MaxSearchPages = 5;
+
+	// Time budget of a single page, so a slow backend can't keep the player waiting on the whole search.
+	UPROPERTY(Config)
+	float SearchPageTimeoutSeconds = 3.f;
+};
@@ -0,0 +1,282 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemSoakSubsystem.h"
+#include "CoreGlobals.h"
+#include "Engine/GameInstance.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "MenuSystemCharacter.h"
+#include "MenuSystemSessionSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMenuSystemSoak, Log, All);
+
+//////////////////////////////////////////////////////////////////////////
+// UMenuSystemSoakSubsystem
+
+bool UMenuSystemSoakSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && (FParse::Param(FCommandLine::Get(), TEXT("SoakServer")) || FParse::Param(FCommandLine::Get(), TEXT("SoakBot")));
+}
+
+void UMenuSystemSoakSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//both modes go through the normal session path
+	Collection.InitializeDependency<UMenuSystemSessionSubsystem>();
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	if(FParse::Param(CommandLine, TEXT("SoakServer"))){
+		NumBotsToLaunch = MaxBots;
+		FParse::Value(CommandLine, TEXT("SoakBots="), NumBotsToLaunch);
+		BotLaunchInterval = BotLaunchIntervalSeconds;
+		FParse::Value(CommandLine, TEXT("SoakBotInterval="), BotLaunchInterval);
+		FParse::Value(CommandLine, TEXT("SoakDuration="), SoakDuration);
+
+		UE_LOG(LogMenuSystemSoak, Display, TEXT("Soak server: %d bots, one every %.1f s"), NumBotsToLaunch, BotLaunchInterval);
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickServer));
+	}
+	else{
+		int32 Seed = static_cast<int32>(FPlatformProcess::GetCurrentProcessId());
+		FParse::Value(CommandLine, TEXT("SoakSeed="), Seed);
+		BotRandom.Initialize(Seed);
+
+		UE_LOG(LogMenuSystemSoak, Display, TEXT("Soak bot: %s input, seed %d"), BotScript.Num() > 0 ? TEXT("scripted") : TEXT("random"), Seed);
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickBot));
+	}
+}
+
+void UMenuSystemSoakSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	TickHandle.Reset();
+	StopBots();
+	CsvWriter.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UMenuSystemSoakSubsystem::TickServer(float DeltaTime)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	UWorld* World = GameInstance->GetWorld();
+	if(World == nullptr || GameInstance->GetFirstLocalPlayerController() == nullptr){
+		return true;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	//host, and host again if the lobby did not come up in time
+	if(World->GetNetMode() != NM_ListenServer){
+		UMenuSystemSessionSubsystem* SessionSubsystem = GameInstance->GetSubsystem<UMenuSystemSessionSubsystem>();
+		if(!bSoakStarted && SessionSubsystem && SessionSubsystem->GetHostState() == EMenuSystemHostState::Idle && (LastHostRequestTime == 0. || Now - LastHostRequestTime >= JoinRetrySeconds)){
+			SessionSubsystem->CreateGameSession();
+			LastHostRequestTime = Now;
+		}
+		return true;
+	}
+
+	if(!bSoakStarted){
+		//memory of the lobby without any client, what comes on top of it is the cost of the players
+		bSoakStarted = true;
+		SoakStartTime = Now;
+		LastSampleTime = Now;
+		LastBotLaunchTime = Now - BotLaunchInterval;
+		BaselineUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		OpenCsv();
+	}
+
+	const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	GameThreadMsSum += GameThreadMs;
+	GameThreadMsMax = FMath::Max(GameThreadMsMax, GameThreadMs);
+	NumFramesSampled++;
+
+	if(BotProcesses.Num() < NumBotsToLaunch && Now - LastBotLaunchTime >= BotLaunchInterval){
+		LastBotLaunchTime = Now;
+		if(!LaunchBot()){
+			//it won't work any better next time
+			NumBotsToLaunch = BotProcesses.Num();
+		}
+	}
+
+	if(Now - LastSampleTime >= SampleIntervalSeconds){
+		LastSampleTime = Now;
+		WriteSample(World);
+	}
+
+	if(SoakDuration > 0. && Now - SoakStartTime >= SoakDuration){
+		UE_LOG(LogMenuSystemSoak, Display, TEXT("Soak finished after %.0f s with %d bots"), Now - SoakStartTime, BotProcesses.Num());
+		StopBots();
+		CsvWriter.Reset();
+		TickHandle.Reset();
+		FPlatformMisc::RequestExit(false);
+		return false;
+	}
+	return true;
+}
+
+bool UMenuSystemSoakSubsystem::LaunchBot()
+{
+	FString Params;
+#if WITH_EDITOR
+	//the editor executable needs the project and -game to run it as a client
+	Params = FString::Printf(TEXT("\"%s\" -game "), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()));
+#endif
+	const int32 BotIndex = BotProcesses.Num();
+	Params += FString::Printf(TEXT("-nullrhi -nosound -unattended -SoakBot -SoakSeed=%d -log=SoakBot%d.log"), BotIndex + 1, BotIndex);
+
+	//the bots have to find us through the same backend
+	FString BackendName;
+	if(FParse::Value(FCommandLine::Get(), TEXT("SessionBackend="), BackendName)){
+		Params += FString::Printf(TEXT(" -SessionBackend=%s"), *BackendName);
+	}
+	if(FParse::Param(FCommandLine::Get(), TEXT("LAN"))){
+		Params += TEXT(" -LAN");
+	}
+
+	FProcHandle BotProcess = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Params, true, true, true, nullptr, 0, nullptr, nullptr);
+	if(!BotProcess.IsValid()){
+		UE_LOG(LogMenuSystemSoak, Error, TEXT("Could not launch bot %d: %s %s"), BotIndex, FPlatformProcess::ExecutablePath(), *Params);
+		return false;
+	}
+
+	BotProcesses.Add(BotProcess);
+	UE_LOG(LogMenuSystemSoak, Display, TEXT("Launched bot %d"), BotIndex);
+	return true;
+}
+
+void UMenuSystemSoakSubsystem::StopBots()
+{
+	for(FProcHandle& BotProcess : BotProcesses)
+	{
+		if(FPlatformProcess::IsProcRunning(BotProcess)){
+			FPlatformProcess::TerminateProc(BotProcess, true);
+		}
+		FPlatformProcess::CloseProc(BotProcess);
+	}
+	BotProcesses.Empty();
+}
+
+void UMenuSystemSoakSubsystem::OpenCsv()
+{
+	const FString CsvPath = FPaths::ProjectSavedDir() / TEXT("Soak") / FString::Printf(TEXT("SoakServer-%s.csv"), *FDateTime::Now().ToString());
+	CsvWriter.Reset(IFileManager::Get().CreateFileWriter(*CsvPath));
+	if(!CsvWriter){
+		UE_LOG(LogMenuSystemSoak, Error, TEXT("Could not create %s, the soak runs without a report"), *CsvPath);
+		return;
+	}
+
+	UE_LOG(LogMenuSystemSoak, Display, TEXT("Writing %s"), *CsvPath);
+	WriteCsvLine(TEXT("Seconds,Bots,Connections,GameThreadMsAvg,GameThreadMsMax,InBytesPerSecAvg,OutBytesPerSecAvg,OutBytesPerSecMax,UsedPhysicalMB,MemoryPerPlayerMB"));
+}
+
+void UMenuSystemSoakSubsystem::WriteCsvLine(const FString& Line)
+{
+	if(!CsvWriter){
+		return;
+	}
+
+	//flushed every line, so a crash or a kill still leaves the report up to that point
+	FTCHARToUTF8 Utf8Line(*(Line + LINE_TERMINATOR));
+	CsvWriter->Serialize(const_cast<ANSICHAR*>(Utf8Line.Get()), Utf8Line.Length());
+	CsvWriter->Flush();
+}
+
+void UMenuSystemSoakSubsystem::WriteSample(UWorld* World)
+{
+	//the bandwidth of every client connection, bots and real players alike
+	int32 NumConnections = 0;
+	int64 InBytesPerSecondSum = 0;
+	int64 OutBytesPerSecondSum = 0;
+	int32 OutBytesPerSecondMax = 0;
+	if(const UNetDriver* NetDriver = World->GetNetDriver()){
+		for(const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			if(Connection == nullptr){
+				continue;
+			}
+			NumConnections++;
+			InBytesPerSecondSum += Connection->InBytesPerSecond;
+			OutBytesPerSecondSum += Connection->OutBytesPerSecond;
+			OutBytesPerSecondMax = FMath::Max(OutBytesPerSecondMax, Connection->OutBytesPerSecond);
+		}
+	}
+
+	const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	const double MemoryPerPlayerMB = NumConnections > 0 ? (static_cast<int64>(UsedPhysical) - static_cast<int64>(BaselineUsedPhysical)) / (1024. * 1024.) / NumConnections : 0.;
+
+	WriteCsvLine(FString::Printf(TEXT("%.1f,%d,%d,%.3f,%.3f,%.0f,%.0f,%d,%.1f,%.2f"),
+		FPlatformTime::Seconds() - SoakStartTime,
+		BotProcesses.Num(),
+		NumConnections,
+		NumFramesSampled > 0 ? GameThreadMsSum / NumFramesSampled : 0.,
+		GameThreadMsMax,
+		NumConnections > 0 ? static_cast<double>(InBytesPerSecondSum) / NumConnections : 0.,
+		NumConnections > 0 ? static_cast<double>(OutBytesPerSecondSum) / NumConnections : 0.,
+		OutBytesPerSecondMax,
+		UsedPhysical / (1024. * 1024.),
+		MemoryPerPlayerMB));
+
+	GameThreadMsSum = 0.;
+	GameThreadMsMax = 0.;
+	NumFramesSampled = 0;
+}
+
+bool UMenuSystemSoakSubsystem::TickBot(float DeltaTime)
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	UWorld* World = GameInstance->GetWorld();
+	APlayerController* PlayerController = GameInstance->GetFirstLocalPlayerController();
+	if(World == nullptr || PlayerController == nullptr){
+		return true;
+	}
+
+	//not connected (yet, or any more): search and join again once the last attempt had its time
+	if(World->GetNetMode() != NM_Client){
+		const double Now = FPlatformTime::Seconds();
+		UMenuSystemSessionSubsystem* SessionSubsystem = GameInstance->GetSubsystem<UMenuSystemSessionSubsystem>();
+		if(SessionSubsystem && (LastJoinTime == 0. || Now - LastJoinTime >= JoinRetrySeconds)){
+			SessionSubsystem->JoinGameSession();
+			LastJoinTime = Now;
+		}
+		return true;
+	}
+
+	AMenuSystemCharacter* Character = Cast<AMenuSystemCharacter>(PlayerController->GetPawn());
+	if(Character){
+		const FMenuSystemSoakBotStep& Step = GetBotStep(DeltaTime);
+		Character->ApplyBotInput(Step.Forward, Step.Right, Step.TurnRate, Step.bJump);
+	}
+	return true;
+}
+
+const FMenuSystemSoakBotStep& UMenuSystemSoakSubsystem::GetBotStep(float DeltaTime)
+{
+	BotStepTimeLeft -= DeltaTime;
+	if(BotStepTimeLeft > 0.f){
+		return BotScript.IsValidIndex(BotScriptIndex) ? BotScript[BotScriptIndex] : RandomStep;
+	}
+
+	if(BotScript.Num() > 0){
+		BotScriptIndex = (BotScriptIndex + 1) % BotScript.Num();
+		BotStepTimeLeft = BotScript[BotScriptIndex].Duration;
+		return BotScript[BotScriptIndex];
+	}
+
+	//mostly running around, turning a little and jumping now and then, like a player waiting in a lobby
+	RandomStep.Duration = BotRandom.FRandRange(1.f, 3.f);
+	RandomStep.Forward = BotRandom.FRandRange(-1.f, 1.f);
+	RandomStep.Right = BotRandom.FRandRange(-1.f, 1.f);
+	RandomStep.TurnRate = BotRandom.FRandRange(-0.5f, 0.5f);
+	RandomStep.bJump = BotRandom.FRand() < 0.1f;
+	BotStepTimeLeft = RandomStep.Duration;
+	return RandomStep;
+}
@@ -0,0 +1,128 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "Math/RandomStream.h"
+#include "MenuSystemSoakSubsystem.generated.h"
+
+/** One step of a scripted bot: the input it holds for Duration seconds. */
+USTRUCT()
+struct FMenuSystemSoakBotStep
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Config)
+	float Duration = 1.f;
+
+	// Axis values, -1 to 1, as the move and gamepad turn bindings would give them.
+	UPROPERTY(Config)
+	float Forward = 0.f;
+
+	UPROPERTY(Config)
+	float Right = 0.f;
+
+	UPROPERTY(Config)
+	float TurnRate = 0.f;
+
+	UPROPERTY(Config)
+	bool bJump = false;
+};
+
+/**
+ * Soak test of the server side, only created with -SoakServer or -SoakBot on the command line.
+ *
+ * -SoakServer hosts a session through UMenuSystemSessionSubsystem, and once the lobby listens launches headless bot clients
+ * (this executable with -nullrhi -SoakBot) one at a time, up to -SoakBots=. Every SampleIntervalSeconds it appends the game thread
+ * time, the bandwidth of each connection and the memory per player to Saved/Soak/SoakServer-<time>.csv, so the cost of a player can
+ * be read against the number of players. It quits after -SoakDuration= seconds, if given.
+ *
+ * -SoakBot joins through the normal session path (JoinGameSession, retried until connected) and then drives its character with
+ * BotScript, or with random input seeded by -SoakSeed= when there is no script.
+ *
+ * The bots find the server through the session backend of the command line, e.g. -SoakServer -LAN for instances on one machine
+ * (the -LAN and -SessionBackend= of the server are passed on to the bots). The loopback backend only works inside one process.
+ */
+UCLASS(config=Game)
+class UMenuSystemSoakSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	/** Bots launched by the server, used when -SoakBots= is not given */
+	UPROPERTY(Config)
+	int32 MaxBots = 16;
+
+	/** Time between two bot launches, so the samples show the cost of every single player. -SoakBotInterval= overrides it */
+	UPROPERTY(Config)
+	float BotLaunchIntervalSeconds = 10.f;
+
+	/** Time between two rows of the CSV */
+	UPROPERTY(Config)
+	float SampleIntervalSeconds = 1.f;
+
+	/** Time a bot waits for a join to connect before searching again, and the server for its lobby before hosting again */
+	UPROPERTY(Config)
+	float JoinRetrySeconds = 15.f;
+
+	/** Input of the bots, looped. Empty means random input */
+	UPROPERTY(Config)
+	TArray<FMenuSystemSoakBotStep> BotScript;
+
+private:
+	bool TickServer(float DeltaTime);
+	bool TickBot(float DeltaTime);
+
+	/** Launches one more bot client. Returns false if the process could not be created */
+	bool LaunchBot();
+
+	/** Opens the CSV and writes its header */
+	void OpenCsv();
+
+	/** Appends a line to the CSV, if it could be opened */
+	void WriteCsvLine(const FString& Line);
+
+	/** Appends a row for the current number of bots and connections, then resets the frame time accumulators */
+	void WriteSample(UWorld* World);
+
+	/** Returns the input step a bot holds now, picking the next one (scripted or random) once the current one is over */
+	const FMenuSystemSoakBotStep& GetBotStep(float DeltaTime);
+
+	/** Terminates the bots we launched */
+	void StopBots();
+
+	FTSTicker::FDelegateHandle TickHandle;
+
+	// Server state.
+	TArray<FProcHandle> BotProcesses;
+	int32 NumBotsToLaunch = 0;
+	float BotLaunchInterval = 0.f;
+	double SoakDuration = 0.;
+	double SoakStartTime = 0.;
+	double LastBotLaunchTime = 0.;
+	double LastSampleTime = 0.;
+	uint64 BaselineUsedPhysical = 0;
+	double LastHostRequestTime = 0.;
+	bool bSoakStarted = false;
+	TUniquePtr<FArchive> CsvWriter;
+
+	// Game thread time of the frames since the last sample, in ms.
+	double GameThreadMsSum = 0.;
+	double GameThreadMsMax = 0.;
+	int32 NumFramesSampled = 0;
+
+	// Bot state.
+	FRandomStream BotRandom;
+	FMenuSystemSoakBotStep RandomStep;
+	int32 BotScriptIndex = INDEX_NONE;
+	float BotStepTimeLeft = 0.f;
+	double LastJoinTime = 0.;
+};
@@ -0,0 +1,122 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemCharacterMovementComponent.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMenuSystemZigZagTest, "MenuSystem.Movement.ZigZag", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMenuSystemZigZagTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("0 encodes to 0"), (int64)MenuSystemMovement::EncodeZigZag(0), (int64)0);
+	TestEqual(TEXT("-1 encodes to 1"), (int64)MenuSystemMovement::EncodeZigZag(-1), (int64)1);
+	TestEqual(TEXT("1 encodes to 2"), (int64)MenuSystemMovement::EncodeZigZag(1), (int64)2);
+	TestEqual(TEXT("-2 encodes to 3"), (int64)MenuSystemMovement::EncodeZigZag(-2), (int64)3);
+
+	const int32 Values[] = { 0, 1, -1, 63, -64, 12345, -12345, MAX_int32, MIN_int32 };
+	for(const int32 Value : Values){
+		TestEqual(FString::Printf(TEXT("%d survives zigzag coding"), Value), MenuSystemMovement::DecodeZigZag(MenuSystemMovement::EncodeZigZag(Value)), Value);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMenuSystemPackedIntsTest, "MenuSystem.Movement.PackedInts", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMenuSystemPackedIntsTest::RunTest(const FString& Parameters)
+{
+	const TArray<TArray<int32>> Cases = {
+		{ 0, 0, 0 },
+		{ 1, -1, 0 },
+		{ 250, -3, 17 },
+		{ -32768, 32767, 0 },
+		{ MAX_int32, MIN_int32, -1 },
+	};
+	for(const TArray<int32>& Case : Cases){
+		TArray<int32> Values = Case;
+		FBitWriter Writer(0, true);
+		MenuSystemMovement::SerializePackedInts(Writer, Values.GetData(), Values.Num());
+		TestFalse(TEXT("Writing doesn't fail"), Writer.IsError());
+
+		TArray<int32> ReadValues;
+		ReadValues.SetNumZeroed(Case.Num());
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		MenuSystemMovement::SerializePackedInts(Reader, ReadValues.GetData(), ReadValues.Num());
+		TestFalse(TEXT("Reading doesn't fail"), Reader.IsError());
+		TestEqual(TEXT("Every bit written is read"), Reader.GetPosBits(), Writer.GetNumBits());
+		for(int32 Index = 0; Index < Case.Num(); Index++){
+			TestEqual(FString::Printf(TEXT("%d survives the round trip"), Case[Index]), ReadValues[Index], Case[Index]);
+		}
+	}
+
+	//no change costs the length alone
+	int32 Unchanged[3] = { 0, 0, 0 };
+	FBitWriter Writer(0, true);
+	MenuSystemMovement::SerializePackedInts(Writer, Unchanged, UE_ARRAY_COUNT(Unchanged));
+	TestEqual(TEXT("A move without change costs 6 bits"), Writer.GetNumBits(), (int64)6);
+
+	//a length the writer never produces is rejected
+	uint32 BadNumBits = 33;
+	FBitWriter BadWriter(0, true);
+	BadWriter.SerializeBits(&BadNumBits, 6);
+	int32 BadValues[3] = {};
+	FBitReader BadReader(BadWriter.GetData(), BadWriter.GetNumBits());
+	MenuSystemMovement::SerializePackedInts(BadReader, BadValues, UE_ARRAY_COUNT(BadValues));
+	TestTrue(TEXT("A corrupt length sets the error"), BadReader.IsError());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMenuSystemPackedAccelerationTest, "MenuSystem.Movement.PackedAcceleration", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMenuSystemPackedAccelerationTest::RunTest(const FString& Parameters)
+{
+	UMenuSystemCharacterMovementComponent* MovementComponent = NewObject<UMenuSystemCharacterMovementComponent>();
+	MovementComponent->MaxAcceleration = 2048.f;
+
+	//every acceleration the client rounds to is packed exactly and unpacked on the other end of the bit stream
+	const int8 Steps[][2] = { { 0, 0 }, { 127, 0 }, { -127, 0 }, { 90, -90 }, { 1, -1 }, { -64, 127 } };
+	for(const int8* Step : Steps){
+		const FVector Acceleration = MovementComponent->UnpackAcceleration(Step[0], Step[1]);
+		int8 X = 0;
+		int8 Y = 0;
+		if(!TestTrue(FString::Printf(TEXT("%s packs"), *Acceleration.ToString()), MovementComponent->PackAcceleration(Acceleration, X, Y))){
+			continue;
+		}
+
+		FBitWriter Writer(0, true);
+		Writer << X;
+		Writer << Y;
+
+		int8 ReadX = 0;
+		int8 ReadY = 0;
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		Reader << ReadX;
+		Reader << ReadY;
+		TestFalse(TEXT("Reading doesn't fail"), Reader.IsError());
+		TestEqual(FString::Printf(TEXT("%s survives the round trip"), *Acceleration.ToString()), MovementComponent->UnpackAcceleration(ReadX, ReadY), Acceleration);
+	}
+
+	//what can't be sent exactly in two bytes goes in full
+	int8 X = 0;
+	int8 Y = 0;
+	TestFalse(TEXT("An acceleration with a Z doesn't pack"), MovementComponent->PackAcceleration(FVector(100.f, 0.f, 10.f), X, Y));
+	TestFalse(TEXT("An acceleration above the max doesn't pack"), MovementComponent->PackAcceleration(FVector(4096.f, 0.f, 0.f), X, Y));
+	TestFalse(TEXT("An acceleration we did not round doesn't pack"), MovementComponent->PackAcceleration(FVector(1000.3f, 0.f, 0.f), X, Y));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMenuSystemTimeStampCheckBitsTest, "MenuSystem.Movement.TimeStampCheckBits", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMenuSystemTimeStampCheckBitsTest::RunTest(const FString& Parameters)
+{
+	//the moves sharing a sequence slot are 256 moves apart, at 60 moves a second and up to the time stamp reset
+	for(float TimeStamp = 1.f; TimeStamp < 240.f; TimeStamp += 7.3f){
+		const float WrappedTimeStamp = TimeStamp + 256.f / 60.f;
+		TestNotEqual(FString::Printf(TEXT("%f and %f are told apart"), TimeStamp, WrappedTimeStamp), MenuSystemMovement::GetTimeStampCheckBits(TimeStamp), MenuSystemMovement::GetTimeStampCheckBits(WrappedTimeStamp));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,328 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MenuSystemLoopbackSessionBackend.h"
+#include "MenuSystemSessionQuery.h"
+#include "MenuSystemSessionRanking.h"
+#include "MenuSystemSessionSubsystem.h"
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MenuSystemSessionSpec
+{
+	/** A search result advertising the keys of Query, the way a host running Query's settings would */
+	static FOnlineSessionSearchResult MakeSearchResult(const FMenuSystemSessionQuery& Query, int32 OpenSlots, int32 PingInMs)
+	{
+		FOnlineSessionSettings Settings;
+		Settings.NumPublicConnections = 8;
+		Query.AdvertiseIn(Settings);
+
+		FOnlineSessionSearchResult SearchResult;
+		SearchResult.Session = FOnlineSession(Settings);
+		SearchResult.Session.NumOpenPublicConnections = OpenSlots;
+		SearchResult.PingInMs = PingInMs;
+		return SearchResult;
+	}
+
+	static FOnlineSessionSearchResult MakeSearchResult(const FString& MatchType, int32 OpenSlots, int32 PingInMs)
+	{
+		return MakeSearchResult(FMenuSystemSessionQuery().WithMatchType(MatchType), OpenSlots, PingInMs);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemSessionRankingSpec
+
+BEGIN_DEFINE_SPEC(FMenuSystemSessionRankingSpec, "MenuSystem.Session.Ranking", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+	FMenuSystemSessionRanking Ranking;
+	FMenuSystemSessionQuery Query;
+END_DEFINE_SPEC(FMenuSystemSessionRankingSpec)
+
+void FMenuSystemSessionRankingSpec::Define()
+{
+	using namespace MenuSystemSessionSpec;
+
+	BeforeEach([this]()
+	{
+		Ranking = FMenuSystemSessionRanking();
+		Query = FMenuSystemSessionQuery();
+	});
+
+	Describe("Score", [this]()
+	{
+		It("should prefer the lower ping", [this]()
+		{
+			TestTrue(TEXT("20 ms beats 80 ms"), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 4, 20), Query) > Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 4, 80), Query));
+		});
+
+		It("should score an unknown ping as UnknownPingMs", [this]()
+		{
+			TestEqual(TEXT("Unknown ping"), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 4, MAX_QUERY_PING), Query), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 4, Ranking.UnknownPingMs), Query));
+		});
+
+		It("should break a ping tie on open slots, up to MaxScoredOpenSlots", [this]()
+		{
+			TestTrue(TEXT("3 open slots beat 1"), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 3, 50), Query) > Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 1, 50), Query));
+			TestEqual(TEXT("Slots past MaxScoredOpenSlots are worth nothing"), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 8, 50), Query), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), Ranking.MaxScoredOpenSlots, 50), Query));
+		});
+
+		It("should add the preferred match type bonus only when the query accepts any match type", [this]()
+		{
+			Ranking.PreferredMatchType = TEXT("TeamDeathMatch");
+			const FOnlineSessionSearchResult Preferred = MakeSearchResult(TEXT("TeamDeathMatch"), 4, 50);
+			const FOnlineSessionSearchResult Other = MakeSearchResult(TEXT("FreeForAll"), 4, 50);
+			TestEqual(TEXT("Bonus"), Ranking.Score(Preferred, Query) - Ranking.Score(Other, Query), Ranking.PreferredMatchTypeBonus);
+
+			FMenuSystemSessionRanking NoPreference = Ranking;
+			NoPreference.PreferredMatchType.Empty();
+			Query.WithMatchType(TEXT("TeamDeathMatch"));
+			TestEqual(TEXT("No bonus for the match type the query asks for"), Ranking.Score(Preferred, Query), NoPreference.Score(Preferred, Query));
+		});
+
+		It("should never score full sessions or the ones the query rejects", [this]()
+		{
+			TestEqual(TEXT("Full session"), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 0, 10), Query), TNumericLimits<float>::Lowest());
+
+			Query.WithMatchType(TEXT("TeamDeathMatch"));
+			TestEqual(TEXT("Other match type"), Ranking.Score(MakeSearchResult(TEXT("FreeForAll"), 4, 10), Query), TNumericLimits<float>::Lowest());
+		});
+	});
+
+	Describe("Rank", [this]()
+	{
+		It("should list the joinable results best first", [this]()
+		{
+			Query.WithMatchType(TEXT("FreeForAll"));
+			const TArray<FOnlineSessionSearchResult> SearchResults = {
+				MakeSearchResult(TEXT("FreeForAll"), 4, 120),
+				MakeSearchResult(TEXT("FreeForAll"), 0, 5),
+				MakeSearchResult(TEXT("FreeForAll"), 4, 30),
+				MakeSearchResult(TEXT("TeamDeathMatch"), 4, 5),
+				MakeSearchResult(TEXT("FreeForAll"), 1, 30),
+			};
+
+			TArray<int32> Candidates;
+			Ranking.Rank(SearchResults, Query, Candidates);
+			TestTrue(TEXT("Candidates are 2, 4, 0"), Candidates == TArray<int32>({ 2, 4, 0 }));
+		});
+
+		It("should keep the backend's order for equal scores", [this]()
+		{
+			const TArray<FOnlineSessionSearchResult> SearchResults = {
+				MakeSearchResult(TEXT("FreeForAll"), 2, 40),
+				MakeSearchResult(TEXT("FreeForAll"), 2, 40),
+				MakeSearchResult(TEXT("FreeForAll"), 2, 40),
+			};
+
+			TArray<int32> Candidates;
+			Ranking.Rank(SearchResults, Query, Candidates);
+			TestTrue(TEXT("Candidates are 0, 1, 2"), Candidates == TArray<int32>({ 0, 1, 2 }));
+		});
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemSessionQuerySpec
+
+BEGIN_DEFINE_SPEC(FMenuSystemSessionQuerySpec, "MenuSystem.Session.Query", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+	FMenuSystemSessionQuery Query;
+END_DEFINE_SPEC(FMenuSystemSessionQuerySpec)
+
+void FMenuSystemSessionQuerySpec::Define()
+{
+	using namespace MenuSystemSessionSpec;
+
+	BeforeEach([this]()
+	{
+		Query = FMenuSystemSessionQuery().WithMatchType(TEXT("FreeForAll")).WithRegion(TEXT("EU")).WithBuildVersion(42).WithMinOpenSlots(2);
+	});
+
+	Describe("ApplyTo", [this]()
+	{
+		It("should only filter on the fields that are set", [this]()
+		{
+			FOnlineSessionSearch EmptySearch;
+			FMenuSystemSessionQuery().ApplyTo(EmptySearch);
+			TestEqual(TEXT("Keys of an empty query"), EmptySearch.QuerySettings.SearchParams.Num(), 0);
+
+			FOnlineSessionSearch Search;
+			Query.ApplyTo(Search);
+			TestEqual(TEXT("Keys"), Search.QuerySettings.SearchParams.Num(), 4);
+
+			const FOnlineSessionSearchParam* MinSlots = Search.QuerySettings.SearchParams.Find(SEARCH_MINSLOTSAVAILABLE);
+			if(TestNotNull(TEXT("Min open slots"), MinSlots)){
+				TestTrue(TEXT("Min open slots comparison"), MinSlots->ComparisonOp == EOnlineComparisonOp::GreaterThanEquals);
+			}
+
+			FString MatchType;
+			TestTrue(TEXT("Match type"), Search.QuerySettings.Get(SETTING_MENUSYSTEM_MATCHTYPE, MatchType) && MatchType == TEXT("FreeForAll"));
+		});
+	});
+
+	Describe("Matches", [this]()
+	{
+		It("should accept the sessions hosted with the same query", [this]()
+		{
+			TestTrue(TEXT("Same query"), Query.Matches(MakeSearchResult(Query, 2, 50)));
+		});
+
+		It("should accept anything with an empty query", [this]()
+		{
+			TestTrue(TEXT("Empty query"), FMenuSystemSessionQuery().Matches(MakeSearchResult(FMenuSystemSessionQuery(), 0, 50)));
+		});
+
+		It("should reject the sessions a backend ignoring the filters returns", [this]()
+		{
+			TestFalse(TEXT("Other match type"), Query.Matches(MakeSearchResult(FMenuSystemSessionQuery(Query).WithMatchType(TEXT("TeamDeathMatch")), 2, 50)));
+			TestFalse(TEXT("Other region"), Query.Matches(MakeSearchResult(FMenuSystemSessionQuery(Query).WithRegion(TEXT("US")), 2, 50)));
+			TestFalse(TEXT("Other build"), Query.Matches(MakeSearchResult(FMenuSystemSessionQuery(Query).WithBuildVersion(43), 2, 50)));
+			TestFalse(TEXT("Too few open slots"), Query.Matches(MakeSearchResult(Query, 1, 50)));
+			TestFalse(TEXT("Key not advertised"), Query.Matches(MakeSearchResult(FMenuSystemSessionQuery(Query).WithRegion(FString()), 2, 50)));
+		});
+	});
+
+	Describe("ToCacheKey", [this]()
+	{
+		It("should be the same for equal queries, whatever order they were built in", [this]()
+		{
+			const FMenuSystemSessionQuery SameQuery = FMenuSystemSessionQuery().WithMinOpenSlots(2).WithBuildVersion(42).WithRegion(TEXT("EU")).WithMatchType(TEXT("FreeForAll"));
+			TestEqual(TEXT("Cache key"), SameQuery.ToCacheKey(), Query.ToCacheKey());
+		});
+
+		It("should differ for queries that find different sessions", [this]()
+		{
+			const FString CacheKey = Query.ToCacheKey();
+			TestNotEqual(TEXT("Match type"), FMenuSystemSessionQuery(Query).WithMatchType(TEXT("TeamDeathMatch")).ToCacheKey(), CacheKey);
+			TestNotEqual(TEXT("Region"), FMenuSystemSessionQuery(Query).WithRegion(TEXT("US")).ToCacheKey(), CacheKey);
+			TestNotEqual(TEXT("Build"), FMenuSystemSessionQuery(Query).WithBuildVersion(43).ToCacheKey(), CacheKey);
+			TestNotEqual(TEXT("Open slots"), FMenuSystemSessionQuery(Query).WithMinOpenSlots(1).ToCacheKey(), CacheKey);
+			TestNotEqual(TEXT("LAN"), FMenuSystemSessionQuery(Query).WithLanQuery(true).ToCacheKey(), CacheKey);
+		});
+	});
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMenuSystemSessionSearchCacheSpec
+
+BEGIN_DEFINE_SPEC(FMenuSystemSessionSearchCacheSpec, "MenuSystem.Session.SearchCache", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+	UMenuSystemSessionSubsystem* Subsystem = nullptr;
+	FMenuSystemSessionQuery Query;
+	int32 NumPages = 0;
+	int32 NumFinalPages = 0;
+	int32 NumResults = 0;
+
+	/** Caches one session for Query, received AgeSeconds ago */
+	void AddCachedSearch(double AgeSeconds, int32 OpenSlots = 4);
+END_DEFINE_SPEC(FMenuSystemSessionSearchCacheSpec)
+
+void FMenuSystemSessionSearchCacheSpec::AddCachedSearch(double AgeSeconds, int32 OpenSlots)
+{
+	FMenuSystemCachedSessionSearch& CachedSearch = Subsystem->SearchCache.Add(Query.ToCacheKey());
+	CachedSearch.Results.Add(MenuSystemSessionSpec::MakeSearchResult(Query, OpenSlots, 50));
+	CachedSearch.SearchTime = FPlatformTime::Seconds() - AgeSeconds;
+}
+
+void FMenuSystemSessionSearchCacheSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Subsystem = NewObject<UMenuSystemSessionSubsystem>();
+		Subsystem->AddToRoot();
+		Subsystem->bPreloadLobbyAssets = false;
+		Subsystem->SearchCacheTTLSeconds = 10.f;
+		Subsystem->SearchCacheMaxStaleSeconds = 60.f;
+
+		//slow enough that a refresh is still in flight when the test checks on it
+		FMenuSystemLoopbackSettings Settings;
+		Settings.LatencyMs = 10000.f;
+		Subsystem->SessionBackend = MakeShared<FMenuSystemLoopbackSessionBackend>(Settings);
+
+		Query = FMenuSystemSessionQuery().WithMatchType(TEXT("FreeForAll")).WithMinOpenSlots(1);
+		NumPages = 0;
+		NumFinalPages = 0;
+		NumResults = 0;
+		Subsystem->OnSessionSearchPage.AddLambda([this](TArrayView<const FOnlineSessionSearchResult> NewResults, bool bFinalPage){
+			NumPages++;
+			NumFinalPages += bFinalPage;
+			NumResults += NewResults.Num();
+		});
+	});
+
+	AfterEach([this]()
+	{
+		Subsystem->OnSessionSearchPage.Clear();
+		Subsystem->StopSessionSearch();
+		Subsystem->SessionBackend.Reset();
+		Subsystem->RemoveFromRoot();
+		Subsystem = nullptr;
+	});
+
+	It("should answer a search from fresh results without asking the backend", [this]()
+	{
+		AddCachedSearch(1.);
+		Subsystem->FindGameSessions(Query);
+
+		TestEqual(TEXT("Pages"), NumPages, 1);
+		TestEqual(TEXT("Final pages"), NumFinalPages, 1);
+		TestEqual(TEXT("Results"), NumResults, 1);
+		TestFalse(TEXT("Searching"), Subsystem->IsSearchingSessions());
+	});
+
+	It("should show stale results right away and refresh them from the backend", [this]()
+	{
+		AddCachedSearch(30.);
+		Subsystem->FindGameSessions(Query);
+
+		TestEqual(TEXT("Pages"), NumPages, 1);
+		TestEqual(TEXT("Final pages"), NumFinalPages, 0);
+		TestEqual(TEXT("Results"), NumResults, 1);
+		TestTrue(TEXT("Searching"), Subsystem->IsSearchingSessions());
+	});
+
+	It("should drop results past SearchCacheMaxStaleSeconds and ask the backend", [this]()
+	{
+		AddCachedSearch(120.);
+		Subsystem->FindGameSessions(Query);
+
+		TestEqual(TEXT("Pages"), NumPages, 0);
+		TestTrue(TEXT("Searching"), Subsystem->IsSearchingSessions());
+		TestFalse(TEXT("Cached"), Subsystem->SearchCache.Contains(Query.ToCacheKey()));
+	});
+
+	It("should ask the backend again when joining finds nothing joinable in fresh results", [this]()
+	{
+		AddCachedSearch(1., 0);
+		Subsystem->JoinGameSession(Query);
+
+		TestEqual(TEXT("Final pages"), NumFinalPages, 0);
+		TestFalse(TEXT("Joining"), Subsystem->IsJoiningSession());
+		TestTrue(TEXT("Searching"), Subsystem->IsSearchingSessions());
+	});
+
+	It("should not answer a different query from the cache", [this]()
+	{
+		AddCachedSearch(1.);
+		Subsystem->FindGameSessions(FMenuSystemSessionQuery(Query).WithRegion(TEXT("US")));
+
+		TestEqual(TEXT("Pages"), NumPages, 0);
+		TestTrue(TEXT("Searching"), Subsystem->IsSearchingSessions());
+	});
+
+	It("should keep only MaxCachedSearches queries, dropping the oldest", [this]()
+	{
+		Subsystem->MaxCachedSearches = 2;
+		AddCachedSearch(5.);
+		const FString OldestKey = Query.ToCacheKey();
+		Query.WithRegion(TEXT("EU"));
+		AddCachedSearch(3.);
+		Query.WithRegion(TEXT("US"));
+		Subsystem->SearchQuery = Query;
+		Subsystem->UpdateSearchCache();
+
+		TestEqual(TEXT("Cached queries"), Subsystem->SearchCache.Num(), 2);
+		TestFalse(TEXT("Oldest query cached"), Subsystem->SearchCache.Contains(OldestKey));
+	});
+}
+
+#endif